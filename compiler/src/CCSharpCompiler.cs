@@ -51,6 +51,7 @@ namespace CCSharpCompiler;
     public static bool debug = false;
     public static bool no_npe_checks = false;
     public static bool no_abe_checks = false;
+    public static bool stats = false;
     public static List<string> refs = new List<string>();
     public static List<string> libs = new List<string>();
 
@@ -84,6 +85,8 @@ namespace CCSharpCompiler;
         Console.WriteLine("    disable NPE checks");
         Console.WriteLine("  --no-abe-checks");
         Console.WriteLine("    disable ABE checks");
+        Console.WriteLine("  --stats");
+        Console.WriteLine("    print NPE/ABE checks removed per file");
         Console.WriteLine("  --console");
         Console.WriteLine("    create console app");
         return;
@@ -136,6 +139,9 @@ namespace CCSharpCompiler;
         if (arg == "--no-abe-checks") {
           no_abe_checks = true;
         }
+        if (arg == "--stats") {
+          stats = true;
+        }
         if (arg == "--ref") {
           if (value.Length == 0) {
             Console.WriteLine("Error:--ref requires a file");
@@ -251,6 +257,7 @@ namespace CCSharpCompiler;
       foreach(Source node in files)
       {
         node.model = compiler.GetSemanticModel(node.tree);
+        node.checks = new Checks(node.model);
         if (printTree) {
           PrintNodes(node, node.tree.GetRoot().ChildNodes(), 0, true);
         }
@@ -303,6 +310,7 @@ namespace CCSharpCompiler;
       string baseFile = file.Substring(csFolder.Length + 1);
       baseFile = baseFile.Substring(0, baseFile.Length - 3).Replace(".", "_").Replace(path_sep, "_");
       node.cppFile = cppFolder + path_sep + baseFile + ".cpp";
+      node.literalPool = "$literals_" + target + "_" + baseFile;
       node.clss = new List<Class>();
       ninja_cpp.Append("build obj/" + baseFile + ext_obj + " : cpp " + node.cppFile + "\r\n");
       ninja_target.Append(" obj/" + baseFile + ext_obj);
@@ -485,7 +493,7 @@ namespace CCSharpCompiler;
     }
 
     public static void BuildNinjaLinux() {
-      ninja_header.Append("cflags = -std=c++17 -fPIC");
+      ninja_header.Append("cflags = -std=c++17 -fPIC -fwrapv");  //C# int arithmetic wraps (unchecked)
       if (debug) {
         ninja_header.Append(" -g");
       } else {
@@ -553,6 +561,19 @@ namespace CCSharpCompiler;
     public SyntaxTree tree;
     public SemanticModel model;
     public List<Class> clss;
+    public string literalPool;  //Core::$literals_<target>_<file> : interned string literals (built in Library_<target>_ctor)
+    public List<string> literals = new List<string>();
+    public Checks checks;  //null / bounds checks the generator can leave out
+
+    /** Returns the pool slot of a string literal (C++ constant u"..."). */
+    public string GetLiteral(string value) {
+      int idx = literals.IndexOf(value);
+      if (idx == -1) {
+        idx = literals.Count;
+        literals.Add(value);
+      }
+      return "Core::" + literalPool + "[" + idx + "]";
+    }
 
     public bool UpToDate() {
       if (Program.linux) return false;  //test
@@ -576,6 +597,404 @@ namespace CCSharpCompiler;
     }
   }
 
+  /** Class hierarchy analysis of the whole program (every source file) : classes without subclasses become C++ final
+   * and so do virtual methods that no subclass declares again, which lets the C++ compiler bind calls directly.
+   * A library can be extended by other programs so only its sealed classes are leaves.
+   */
+  static class Hierarchy
+  {
+    private static HashSet<ISymbol> classes = new HashSet<ISymbol>(SymbolEqualityComparer.Default);
+    private static HashSet<ISymbol> derived = new HashSet<ISymbol>(SymbolEqualityComparer.Default);  //classes with a subclass
+    private static HashSet<string> redeclared = new HashSet<string>();  //class:method declared again in a subclass
+
+    public static void Build(List<Source> files) {
+      foreach(Source file in files) {
+        foreach(var node in file.tree.GetRoot().DescendantNodes()) {
+          if (!(node is TypeDeclarationSyntax)) continue;
+          INamedTypeSymbol symbol = file.model.GetDeclaredSymbol(node) as INamedTypeSymbol;
+          if (symbol == null) continue;
+          classes.Add(symbol.OriginalDefinition);
+          for(INamedTypeSymbol parent = symbol.BaseType; parent != null; parent = parent.BaseType) {
+            derived.Add(parent.OriginalDefinition);
+            foreach(var member in symbol.GetMembers()) {
+              if (member.Kind == SymbolKind.Method) redeclared.Add(Key(parent, member.Name));
+            }
+          }
+        }
+      }
+    }
+
+    private static string Key(INamedTypeSymbol cls, string name) {
+      return cls.OriginalDefinition.ToDisplayString() + ":" + name;
+    }
+
+    /** Class that can not have subclasses : an object of static type cls is exactly a cls. */
+    public static bool IsLeaf(INamedTypeSymbol cls) {
+      if (cls == null || cls.TypeKind != TypeKind.Class || cls.IsAbstract || cls.IsStatic) return false;
+      if (derived.Contains(cls.OriginalDefinition)) return false;
+      return cls.IsSealed || (!Program.library && classes.Contains(cls.OriginalDefinition));
+    }
+
+    /** Virtual (or override) method that no subclass can override. */
+    public static bool IsFinal(ISymbol symbol) {
+      IMethodSymbol method = symbol as IMethodSymbol;
+      if (method == null || method.MethodKind != MethodKind.Ordinary) return false;
+      if (!(method.IsVirtual || method.IsOverride) || method.IsAbstract) return false;
+      INamedTypeSymbol cls = method.ContainingType;
+      if (cls.TypeKind != TypeKind.Class || redeclared.Contains(Key(cls, method.Name))) return false;
+      return method.IsSealed || IsLeaf(cls) || (!Program.library && classes.Contains(cls.OriginalDefinition));
+    }
+  }
+
+  /** Finds member accesses that can not throw NullPointerException and array accesses that can not throw ArrayBoundsException.
+   * Only locals and by-value parameters are tracked (fields can change in calls and other threads).
+   * A receiver is non-null when it is this / new / a literal, or when an earlier statement of an enclosing block
+   * (or the condition of an enclosing if / while / for) already dereferenced it and nothing assigned it since.
+   * An element access arr[i] is in bounds inside for(int i=K;i<arr.Length;i++) {...} when the body never assigns i or arr.
+   * A local that is only ever assigned by its new T() initializer holds exactly a T (see ExactType).
+   */
+  class Checks
+  {
+    public int nullTotal, nullRemoved;
+    public int boundsTotal, boundsRemoved;
+    private SemanticModel model;
+
+    public Checks(SemanticModel model) {
+      this.model = model;
+    }
+
+    public bool IsNonNull(SyntaxNode receiver) {
+      nullTotal++;
+      if (!NonNull(receiver)) return false;
+      nullRemoved++;
+      return true;
+    }
+
+    public bool IsInBounds(SyntaxNode node) {
+      boundsTotal++;
+      if (!InBounds((ElementAccessExpressionSyntax)node)) return false;
+      boundsRemoved++;
+      return true;
+    }
+
+    private bool NonNull(SyntaxNode receiver) {
+      receiver = Unwrap(receiver);
+      switch (receiver.Kind()) {
+        case SyntaxKind.ThisExpression:
+        case SyntaxKind.ObjectCreationExpression:
+        case SyntaxKind.ArrayCreationExpression:
+        case SyntaxKind.StringLiteralExpression:
+          return true;
+      }
+      ISymbol local = GetLocal(receiver);
+      if (local == null) return false;
+      SyntaxNode body = GetBody(receiver);
+      if (body == null || HasGoto(body)) return false;
+      List<SyntaxNode> writes = GetWrites(body, local);
+      if (writes == null) return false;
+      if (writes.Count == 0 && GetNewInitializer(local) != null) return true;
+      int pos = receiver.SpanStart;
+      SyntaxNode cur = receiver;
+      while (cur != body) {
+        SyntaxNode parent = cur.Parent;
+        switch (parent.Kind()) {
+          case SyntaxKind.CatchClause:
+          case SyntaxKind.FinallyClause:
+            return false;
+          case SyntaxKind.WhileStatement:
+          case SyntaxKind.DoStatement:
+          case SyntaxKind.ForStatement:
+          case SyntaxKind.ForEachStatement:
+            //the back edge brings writes from anywhere in the loop
+            if (WritesInside(writes, parent)) return false;
+            break;
+        }
+        int proof = -1;
+        switch (parent.Kind()) {
+          case SyntaxKind.Block:
+            SyntaxList<StatementSyntax> stmts = ((BlockSyntax)parent).Statements;
+            for(int idx = stmts.IndexOf((StatementSyntax)cur) - 1; idx >= 0 && proof == -1; idx--) {
+              proof = Proof(stmts[idx], local);
+            }
+            break;
+          case SyntaxKind.IfStatement:
+            IfStatementSyntax ifStmt = (IfStatementSyntax)parent;
+            if (cur != ifStmt.Condition) proof = Dereferences(ifStmt.Condition, local);
+            break;
+          case SyntaxKind.WhileStatement:
+            WhileStatementSyntax whileStmt = (WhileStatementSyntax)parent;
+            if (cur == whileStmt.Statement) proof = Dereferences(whileStmt.Condition, local);
+            break;
+          case SyntaxKind.ForStatement:
+            ForStatementSyntax forStmt = (ForStatementSyntax)parent;
+            if (cur == forStmt.Statement && forStmt.Condition != null) proof = Dereferences(forStmt.Condition, local);
+            break;
+        }
+        if (proof != -1) {
+          //the nearest proof decides : any older one is also followed by the same writes
+          return !WritesBetween(writes, proof, pos);
+        }
+        cur = parent;
+      }
+      return false;
+    }
+
+    /** new T() the receiver always holds (null if unknown or T is generic). */
+    public ObjectCreationExpressionSyntax ExactType(SyntaxNode receiver) {
+      receiver = Unwrap(receiver);
+      ObjectCreationExpressionSyntax creation = receiver as ObjectCreationExpressionSyntax;
+      if (creation == null) {
+        ILocalSymbol local = GetLocal(receiver) as ILocalSymbol;
+        if (local == null) return null;
+        creation = GetNewInitializer(local) as ObjectCreationExpressionSyntax;
+        if (creation == null) return null;
+        //Base b = new Derived() : b->Derived::M() would not compile
+        if (!SymbolEqualityComparer.Default.Equals(local.Type, model.GetTypeInfo(creation).Type)) return null;
+        SyntaxNode body = GetBody(receiver);
+        if (body == null) return null;
+        List<SyntaxNode> writes = GetWrites(body, local);
+        if (writes == null || writes.Count > 0) return null;
+      }
+      INamedTypeSymbol type = model.GetTypeInfo(creation).Type as INamedTypeSymbol;
+      if (type == null || type.TypeKind != TypeKind.Class || type.IsGenericType) return null;
+      return creation;
+    }
+
+    //new T() / new T[] that initializes local (null if none)
+    private SyntaxNode GetNewInitializer(ISymbol local) {
+      if (local.Kind != SymbolKind.Local || local.DeclaringSyntaxReferences.Length != 1) return null;
+      VariableDeclaratorSyntax variable = local.DeclaringSyntaxReferences[0].GetSyntax() as VariableDeclaratorSyntax;
+      if (variable == null || variable.Initializer == null) return null;
+      SyntaxNode value = Unwrap(variable.Initializer.Value);
+      return IsNew(value) ? value : null;
+    }
+
+    private bool InBounds(ElementAccessExpressionSyntax node) {
+      if (node.ArgumentList.Arguments.Count != 1) return false;
+      ISymbol array = GetLocal(node.Expression);
+      ISymbol index = GetLocal(node.ArgumentList.Arguments[0].Expression);
+      if (array == null || index == null) return false;
+      if (!(model.GetTypeInfo(node.Expression).Type is IArrayTypeSymbol)) return false;
+      SyntaxNode body = GetBody(node);
+      if (body == null) return false;
+      //find the for loop that declares the index
+      ForStatementSyntax loop = null;
+      for(SyntaxNode cur = node; cur != body; cur = cur.Parent) {
+        ForStatementSyntax forStmt = cur.Parent as ForStatementSyntax;
+        if (forStmt != null && cur == forStmt.Statement && IsCountedLoop(forStmt, index, array)) {
+          loop = forStmt;
+          break;
+        }
+      }
+      if (loop == null) return false;
+      List<SyntaxNode> indexWrites = GetWrites(body, index);
+      List<SyntaxNode> arrayWrites = GetWrites(body, array);
+      if (indexWrites == null || arrayWrites == null) return false;
+      return !WritesInside(indexWrites, loop.Statement) && !WritesInside(arrayWrites, loop);
+    }
+
+    //for(int i=K;i<array.Length;i++) with constant K >= 0
+    private bool IsCountedLoop(ForStatementSyntax loop, ISymbol index, ISymbol array) {
+      if (loop.Declaration == null || loop.Declaration.Variables.Count != 1) return false;
+      VariableDeclaratorSyntax variable = loop.Declaration.Variables[0];
+      if (!SymbolEqualityComparer.Default.Equals(model.GetDeclaredSymbol(variable), index)) return false;
+      if (((ILocalSymbol)index).Type.SpecialType != SpecialType.System_Int32) return false;
+      if (variable.Initializer == null) return false;
+      Optional<object> start = model.GetConstantValue(variable.Initializer.Value);
+      if (!start.HasValue || !(start.Value is int) || (int)start.Value < 0) return false;
+      BinaryExpressionSyntax cond = loop.Condition as BinaryExpressionSyntax;
+      if (cond == null || cond.Kind() != SyntaxKind.LessThanExpression) return false;
+      if (!IsSymbol(cond.Left, index)) return false;
+      MemberAccessExpressionSyntax length = Unwrap(cond.Right) as MemberAccessExpressionSyntax;
+      if (length == null || length.Name.Identifier.Text != "Length" || !IsSymbol(length.Expression, array)) return false;
+      if (loop.Incrementors.Count != 1) return false;
+      ExpressionSyntax inc = loop.Incrementors[0];
+      switch (inc.Kind()) {
+        case SyntaxKind.PostIncrementExpression:
+          return IsSymbol(((PostfixUnaryExpressionSyntax)inc).Operand, index);
+        case SyntaxKind.PreIncrementExpression:
+          return IsSymbol(((PrefixUnaryExpressionSyntax)inc).Operand, index);
+        case SyntaxKind.AddAssignmentExpression:
+          AssignmentExpressionSyntax add = (AssignmentExpressionSyntax)inc;
+          Optional<object> step = model.GetConstantValue(add.Right);
+          return IsSymbol(add.Left, index) && step.HasValue && step.Value is int && (int)step.Value == 1;
+      }
+      return false;
+    }
+
+    //position after which statement proves local is non-null (-1 = no proof)
+    private int Proof(StatementSyntax stmt, ISymbol local) {
+      switch (stmt.Kind()) {
+        case SyntaxKind.ExpressionStatement:
+          ExpressionSyntax expr = ((ExpressionStatementSyntax)stmt).Expression;
+          AssignmentExpressionSyntax assign = expr as AssignmentExpressionSyntax;
+          if (assign != null && assign.Kind() == SyntaxKind.SimpleAssignmentExpression && IsSymbol(assign.Left, local) && IsNew(assign.Right)) {
+            return stmt.Span.End;
+          }
+          return Dereferences(expr, local);
+        case SyntaxKind.LocalDeclarationStatement:
+          foreach(var variable in ((LocalDeclarationStatementSyntax)stmt).Declaration.Variables) {
+            if (variable.Initializer == null) continue;
+            if (IsNew(variable.Initializer.Value) && SymbolEqualityComparer.Default.Equals(model.GetDeclaredSymbol(variable), local)) {
+              return stmt.Span.End;
+            }
+          }
+          return Dereferences(stmt, local);
+        case SyntaxKind.IfStatement:
+          return Dereferences(((IfStatementSyntax)stmt).Condition, local);
+      }
+      return -1;
+    }
+
+    //end of the last member access on local that is always evaluated with node (-1 = none)
+    private int Dereferences(SyntaxNode node, ISymbol local) {
+      int proof = -1;
+      foreach(var access in node.DescendantNodesAndSelf(child => !IsConditional(child))) {
+        if (access.Kind() != SyntaxKind.SimpleMemberAccessExpression) continue;
+        MemberAccessExpressionSyntax member = (MemberAccessExpressionSyntax)access;
+        if (!IsSymbol(member.Expression, local)) continue;
+        ISymbol symbol = model.GetSymbolInfo(member.Name).Symbol;
+        if (symbol == null || symbol.IsStatic) continue;
+        IMethodSymbol methodSymbol = symbol as IMethodSymbol;
+        if (methodSymbol != null && methodSymbol.IsExtensionMethod) continue;
+        if (IsOptional(access, node)) continue;
+        if (access.Span.End > proof) proof = access.Span.End;
+      }
+      return proof;
+    }
+
+    //nodes whose children are not always evaluated
+    private static bool IsConditional(SyntaxNode node) {
+      switch (node.Kind()) {
+        case SyntaxKind.ParenthesizedLambdaExpression:
+        case SyntaxKind.SimpleLambdaExpression:
+        case SyntaxKind.AnonymousMethodExpression:
+        case SyntaxKind.LocalFunctionStatement:
+        case SyntaxKind.ConditionalAccessExpression:
+          return true;
+      }
+      return false;
+    }
+
+    //inside the right side of && || ?? or a branch of ?: (below top)
+    private static bool IsOptional(SyntaxNode node, SyntaxNode top) {
+      for(SyntaxNode cur = node; cur != top; cur = cur.Parent) {
+        SyntaxNode parent = cur.Parent;
+        switch (parent.Kind()) {
+          case SyntaxKind.LogicalAndExpression:
+          case SyntaxKind.LogicalOrExpression:
+          case SyntaxKind.CoalesceExpression:
+            if (cur == ((BinaryExpressionSyntax)parent).Right) return true;
+            break;
+          case SyntaxKind.ConditionalExpression:
+            if (cur != ((ConditionalExpressionSyntax)parent).Condition) return true;
+            break;
+        }
+      }
+      return false;
+    }
+
+    private static bool IsNew(SyntaxNode node) {
+      node = Unwrap(node);
+      return node.Kind() == SyntaxKind.ObjectCreationExpression || node.Kind() == SyntaxKind.ArrayCreationExpression;
+    }
+
+    private static SyntaxNode Unwrap(SyntaxNode node) {
+      while (node.Kind() == SyntaxKind.ParenthesizedExpression) {
+        node = ((ParenthesizedExpressionSyntax)node).Expression;
+      }
+      return node;
+    }
+
+    //local variable or by-value parameter named by node (null for anything else)
+    private ISymbol GetLocal(SyntaxNode node) {
+      node = Unwrap(node);
+      if (node.Kind() != SyntaxKind.IdentifierName) return null;
+      ISymbol symbol = model.GetSymbolInfo(node).Symbol;
+      ILocalSymbol local = symbol as ILocalSymbol;
+      if (local != null) return local.IsRef ? null : local;
+      IParameterSymbol param = symbol as IParameterSymbol;
+      if (param != null) return param.RefKind == RefKind.None ? param : null;
+      return null;
+    }
+
+    private bool IsSymbol(SyntaxNode node, ISymbol symbol) {
+      node = Unwrap(node);
+      if (node.Kind() != SyntaxKind.IdentifierName) return false;
+      return SymbolEqualityComparer.Default.Equals(model.GetSymbolInfo(node).Symbol, symbol);
+    }
+
+    //method, accessor, constructor or operator body that contains node (null inside lambdas and local functions)
+    private static SyntaxNode GetBody(SyntaxNode node) {
+      for(SyntaxNode cur = node; cur != null; cur = cur.Parent) {
+        if (IsConditional(cur) && cur.Kind() != SyntaxKind.ConditionalAccessExpression) return null;
+        if (cur is BaseMethodDeclarationSyntax || cur is AccessorDeclarationSyntax) return cur;
+      }
+      return null;
+    }
+
+    private static bool HasGoto(SyntaxNode body) {
+      foreach(var node in body.DescendantNodes()) {
+        switch (node.Kind()) {
+          case SyntaxKind.GotoStatement:
+          case SyntaxKind.GotoCaseStatement:
+          case SyntaxKind.GotoDefaultStatement:
+          case SyntaxKind.LabeledStatement:
+            return true;
+        }
+      }
+      return false;
+    }
+
+    //expressions that assign symbol in body (null if a lambda or local function assigns it : it could run anywhere)
+    private List<SyntaxNode> GetWrites(SyntaxNode body, ISymbol symbol) {
+      List<SyntaxNode> writes = new List<SyntaxNode>();
+      foreach(var node in body.DescendantNodes()) {
+        SyntaxNode target = null;
+        SyntaxNode write = node;
+        switch (node.Kind()) {
+          case SyntaxKind.PreIncrementExpression:
+          case SyntaxKind.PreDecrementExpression:
+            target = ((PrefixUnaryExpressionSyntax)node).Operand;
+            break;
+          case SyntaxKind.PostIncrementExpression:
+          case SyntaxKind.PostDecrementExpression:
+            target = ((PostfixUnaryExpressionSyntax)node).Operand;
+            break;
+          case SyntaxKind.Argument:
+            ArgumentSyntax arg = (ArgumentSyntax)node;
+            if (arg.RefKindKeyword.Kind() == SyntaxKind.None) break;
+            target = arg.Expression;
+            write = node.Parent.Parent;  //the call
+            break;
+          default:
+            AssignmentExpressionSyntax assign = node as AssignmentExpressionSyntax;
+            if (assign != null) target = assign.Left;
+            break;
+        }
+        if (target == null || !IsSymbol(target, symbol)) continue;
+        if (GetBody(node) == null) return null;
+        writes.Add(write);
+      }
+      return writes;
+    }
+
+    private static bool WritesInside(List<SyntaxNode> writes, SyntaxNode node) {
+      foreach(var write in writes) {
+        if (node.Span.Contains(write.Span)) return true;
+      }
+      return false;
+    }
+
+    //a write takes effect at the end of its expression
+    private static bool WritesBetween(List<SyntaxNode> writes, int start, int end) {
+      foreach(var write in writes) {
+        if (write.Span.End > start && write.Span.End <= end) return true;
+      }
+      return false;
+    }
+  }
+
   class Generate
   {
     public static Source file;
@@ -597,6 +1016,7 @@ namespace CCSharpCompiler;
       if (Program.printTree) {
         Console.WriteLine();
       }
+      Hierarchy.Build(Program.files);
       foreach(Source file in Program.files) {
         GenerateSource(file);
       }
@@ -680,6 +1100,14 @@ namespace CCSharpCompiler;
         Console.WriteLine("Compiling:" + file.csFile);
       }
       OutputFile(file);
+      if (Program.stats) {
+        //only checks that are emitted (--no-npe-checks / --no-abe-checks generate none)
+        Checks checks = file.checks;
+        String line = "";
+        if (!Program.no_npe_checks && checks.nullTotal > 0) line += " null " + checks.nullRemoved + "/" + checks.nullTotal;
+        if (!Program.no_abe_checks && checks.boundsTotal > 0) line += " bounds " + checks.boundsRemoved + "/" + checks.boundsTotal;
+        if (line.Length > 0) Console.WriteLine("Checks removed:" + file.csFile + " :" + line);
+      }
     }
 
     private void OpenOutput(string filename) {
@@ -705,6 +1133,12 @@ namespace CCSharpCompiler;
       foreach(var lib in Program.libs) {
         sb.Append("#include <" + lib + ".hpp>\r\n");
       }
+      sb.Append("namespace Core {\r\n");
+      foreach(var file in Program.files) {
+        if (file.literals.Count == 0) continue;
+        sb.Append("extern System::String* " + file.literalPool + "[" + file.literals.Count + "];\r\n");
+      }
+      sb.Append("}\r\n");
       foreach(var file in Program.files) {
         foreach(var cls in file.clss) {
           sb.Append(cls.GetReflectionExtern());
@@ -857,9 +1291,10 @@ namespace CCSharpCompiler;
       fs.Write(bytes, 0, bytes.Length);
     }
 
-    /** Create default ctor if class has no ctors. */
+    /** Create default ctor if class has no ctors (a struct always has one : new T(), default(T) and T[] elements). */
     private void CreateDefaultCtor(Class cls) {
-      if (!cls.hasctor && !cls.isInterface) {
+      bool needed = !cls.hasctor || (cls.isStruct && !cls.methods.Exists(m => m.ctor && m.args.Count == 0));
+      if (needed && !cls.isInterface) {
       CCSharpCompiler.Generate.cls = cls;
         CtorNode(null);
       }
@@ -906,13 +1341,32 @@ namespace CCSharpCompiler;
     private void WriteStaticFieldsInit() {
       StringBuilder sb = new StringBuilder();
       sb.Append("namespace Core {\r\n");
+      foreach(var file in Program.files) {
+        if (file.literals.Count == 0) continue;
+        sb.Append("System::String* " + file.literalPool + "[" + file.literals.Count + "];\r\n");
+      }
+      //object layouts use offsetof() on polymorphic classes (supported by gcc / clang / msvc)
+      sb.Append("#ifdef __GNUC__\r\n#pragma GCC diagnostic push\r\n#pragma GCC diagnostic ignored \"-Winvalid-offsetof\"\r\n#endif\r\n");
       sb.Append("void Library_" + Program.target + "_ctor() {\r\n");
+      foreach(var file in Program.files) {
+        foreach(var cls in file.clss) {
+          sb.Append(cls.GetLayoutInit());
+        }
+      }
+      //string literals are created once (before static fields that may use them)
+      foreach(var file in Program.files) {
+        for(int idx=0;idx<file.literals.Count;idx++) {
+          sb.Append("Core::Object::GC_add_static_ref((Core::Object**)&" + file.literalPool + "[" + idx + "]);\r\n");
+          sb.Append(file.literalPool + "[" + idx + "] = System::String::Intern(Core::utf16ToString(" + file.literals[idx] + "));\r\n");
+        }
+      }
       foreach(var file in Program.files) {
         foreach(var cls in file.clss) {
           sb.Append(cls.GetStaticFieldsInit());
         }
       }
       sb.Append("}};\r\n");
+      sb.Append("#ifdef __GNUC__\r\n#pragma GCC diagnostic pop\r\n#endif\r\n");
       byte[] bytes = new UTF8Encoding().GetBytes(sb.ToString());
       fs.Write(bytes, 0, bytes.Length);
     }
@@ -1034,8 +1488,8 @@ namespace CCSharpCompiler;
       }
       sb.Append(Program.main + "::" + name + "(args);\r\n");
       if (!Program.debug) {
-        sb.Append("} catch (System::Exception *ex) {System::Console::WriteLine(Core::addstr(Core::utf16ToString(u\"Exception caught:\"), ex->ToString()));}\r\n");
-        sb.Append("catch (...) {System::Console::WriteLine(Core::utf16ToString(u\"Unknown exception thrown\"));}\r\n");
+        sb.Append("} catch (System::Exception *ex) {static System::String* $msg; System::Console::WriteLine(Core::concat(Core::$literal(&$msg, u\"Exception caught:\"), ex->ToString()));}\r\n");
+        sb.Append("catch (...) {static System::String* $msg; System::Console::WriteLine(Core::$literal(&$msg, u\"Unknown exception thrown\"));}\r\n");
       }
       return sb.ToString();
     }
@@ -1175,6 +1629,7 @@ namespace CCSharpCompiler;
       }
       cls.nsfullname += cls.fullname;
       cls.isInterface = Interface;
+      cls.isStruct = node.Kind() == SyntaxKind.StructDeclaration;
       init = new Method();
       init.cls = cls;
       init.type.Set("void");
@@ -1250,7 +1705,7 @@ namespace CCSharpCompiler;
       if (cls.nsfullname == "System::Object") {
         cls.bases.Add(new Type(null, "Core::Object"));
       } else {
-        if (cls.bases.Count == 0 && !cls.isInterface) {
+        if (cls.bases.Count == 0 && !cls.isInterface && !cls.isStruct) {
           cls.bases.Add(new Type(null, "System::Object"));
         }
         cls.AddUsage("System::Object");
@@ -1326,11 +1781,18 @@ namespace CCSharpCompiler;
             break;
         }
       }
+      if (field.isStruct && !field.isArray && !field.isStatic) {
+        cls.AddUsage(field.GetSymbol());  //stored inline : the struct must be declared first
+      }
       cls.fields.Add(field);
     }
 
     private void FieldEquals(Variable v) {
       method = v.method;
+      bool barrier = !field.isStatic && (field.isObject || field.isArray || (field.isStruct && HasReferences(field.typeSymbol)));
+      if (barrier) {
+        method.Append("Core::$wb(&(");
+      }
       if (field.isStatic) {
         if (cls.Namespace.Length > 0) {
           method.Append(cls.Namespace);
@@ -1340,13 +1802,20 @@ namespace CCSharpCompiler;
         method.Append("::");
       }
       method.Append(v.name);
-      method.Append(" = ");
+      if (barrier) {
+        method.Append("),");
+      } else {
+        method.Append(" = ");
+      }
       SyntaxNode equalsChild = GetChildNode(v.equals);
       if (equalsChild.Kind() == SyntaxKind.ArrayInitializerExpression) {
         NewArrayInitNode(equalsChild, field, field.arrays);
       } else {
         ExpressionNode(equalsChild);
       }
+      if (barrier) {
+        method.Append(")");
+      }
       method.Append(";\r\n");
     }
 
@@ -1425,7 +1894,11 @@ namespace CCSharpCompiler;
         method.type.Set("void");
         method.type.SetTypes();
         method.type.isVirtual = true;
-        method.Append("{" + v.name + ".Value = value;}\r\n");
+        if (field.isObject || field.isArray) {
+          method.Append("{Core::$wb(&(" + v.name + ".Value), value);}\r\n");
+        } else {
+          method.Append("{" + v.name + ".Value = value;}\r\n");
+        }
         cls.methods.Add(method);
       }
       //call Property<T>.Init() in ctor
@@ -1515,7 +1988,7 @@ namespace CCSharpCompiler;
               method.src.Length = 0;
               break;
             case SyntaxKind.Block:
-              BlockNode(child, true, false, true);
+              BlockNode(child, true, true);
               break;
           }
         }
@@ -1621,8 +2094,10 @@ namespace CCSharpCompiler;
               type.Set("auto");
             }
             Argument arg = new Argument();
-            arg.name.name = ConvertName(file.model.GetDeclaredSymbol(param).Name.Replace(".", "::"));
+            IParameterSymbol psymbol = (IParameterSymbol)file.model.GetDeclaredSymbol(param);
+            arg.name.name = ConvertName(psymbol.Name.Replace(".", "::"));
             arg.type = type;
+            arg.refKind = psymbol.RefKind;
             method.args.Add(arg);
             SyntaxNode equals = GetChildNode(param, 2);
             if (equals != null && equals.Kind() == SyntaxKind.EqualsValueClause) {
@@ -1680,12 +2155,13 @@ namespace CCSharpCompiler;
       }
     }
 
-    private void BlockNode(SyntaxNode node, bool top = false, bool throwFinally = false, bool ctor = false) {
+    private void BlockNode(SyntaxNode node, bool top = false, bool ctor = false) {
       method.Append("{\r\n");
       if (ctor) {
         method.Append("$init();\r\n");
       }
       if (top) {
+        method.Append("Core::$gc_poll();\r\n");  //safepoint (method entry)
         if (method.type.isObject) {
           method.Append(method.type.GetTypeDeclaration());
           method.Append(" $ret;\r\n");
@@ -1695,17 +2171,21 @@ namespace CCSharpCompiler;
       foreach(var child in nodes) {
         StatementNode(child);
       }
-      if (throwFinally) {
-        method.Append("throw new System::FinallyException();");
-      }
       method.Append("}\r\n");
     }
 
-    private void StatementNode(SyntaxNode node, bool top = false, bool throwFinally = false) {
+    //loop body with a safepoint poll (runs on every back-edge, including continue)
+    private void LoopBodyNode(SyntaxNode node) {
+      method.Append("{Core::$gc_poll();\r\n");
+      StatementNode(node);
+      method.Append("}\r\n");
+    }
+
+    private void StatementNode(SyntaxNode node, bool top = false) {
       switch (node.Kind()) {
         case SyntaxKind.Block:
         case SyntaxKind.UnsafeStatement:
-          BlockNode(node, top, throwFinally);
+          BlockNode(node, top);
           break;
         case SyntaxKind.ExpressionStatement:
           ExpressionNode(GetChildNode(node));
@@ -1734,7 +2214,7 @@ namespace CCSharpCompiler;
           method.Append("while (");
           ExpressionNode(GetChildNode(node, 1));
           method.Append(")");
-          StatementNode(GetChildNode(node, 2));
+          LoopBodyNode(GetChildNode(node, 2));
           break;
         case SyntaxKind.ForStatement:
           //for(initializers;condition;incrementors) statement
@@ -1760,7 +2240,7 @@ namespace CCSharpCompiler;
             ExpressionNode(GetChildNode(node, pos++));
           }
           method.Append(")");
-          StatementNode(GetChildNode(node, pos));
+          LoopBodyNode(GetChildNode(node, pos));
           break;
         case SyntaxKind.ForEachStatement:
           //foreach(var item in items) {}
@@ -1778,13 +2258,48 @@ namespace CCSharpCompiler;
           method.Append(" ");
           method.Append(foreachName);  //var name : item
           method.Append(";\r\n");
+          string[] indexed = GetIndexedForEach(foreachItems);
+          if (indexed != null) {
+            //T[], Array<T>, List<T>, String : indexed loop over the storage (no enumerator allocation or virtual calls)
+            //count and storage are read every iteration so the body may change the collection
+            method.Append("auto " + enumID + " = $check(");
+            ExpressionNode(foreachItems);  //items
+            method.Append(");\r\n");
+            method.Append("for(int32 " + enumID + "$i=0;" + enumID + "$i<" + enumID + "->" + indexed[0] + ";" + enumID + "$i++) {Core::$gc_poll();\r\n");
+            method.Append(foreachName + " = ");  //var name : item =
+            method.Append(enumID + indexed[1] + "->Array[" + enumID + "$i];\r\n");
+            StatementNode(foreachBlock);
+            method.Append("}}\r\n");
+            break;
+          }
+          IMethodSymbol getEnumerator = file.model.GetForEachStatementInfo((ForEachStatementSyntax)node).GetEnumeratorMethod;
+          if (getEnumerator != null && !getEnumerator.IsExtensionMethod && getEnumerator.ReturnType.TypeKind != TypeKind.Interface) {
+            //GetEnumerator() returns a class or struct with MoveNext() / Current : direct calls instead of IEnumerator<T>
+            //a struct enumerator is a local value (no allocation)
+            String enumAccess = getEnumerator.ReturnType.TypeKind == TypeKind.Struct ? "." : "->";
+            if (IsStructValue(foreachItems)) {
+              method.Append("auto " + enumID + " = (");
+              ExpressionNode(foreachItems);  //items
+              method.Append(").GetEnumerator();\r\n");
+            } else {
+              method.Append("auto " + enumID + " = $check(");
+              ExpressionNode(foreachItems);  //items
+              method.Append(")->GetEnumerator();\r\n");
+            }
+            method.Append("while (" + enumID + enumAccess + "MoveNext()) {Core::$gc_poll();\r\n");
+            method.Append(foreachName + " = ");  //var name : item =
+            method.Append(enumID + enumAccess + "$get_Current();\r\n");
+            StatementNode(foreachBlock);
+            method.Append("}}\r\n");
+            break;
+          }
           method.Append("System::IEnumerator");
           method.Append(foreachType.GetTypeDeclaration());  //var type
           method.Append("> *" + enumID + " = ");
           ExpressionNode(foreachItems);  //items
           method.Append("->GetEnumerator();\r\n");
           method.Append("while (");
-          method.Append(enumID + "->MoveNext()) {\r\n");
+          method.Append(enumID + "->MoveNext()) {Core::$gc_poll();\r\n");
           method.Append(foreachName + " = ");  //var name : item =
           method.Append(enumID + "->$get_Current();\r\n");
           StatementNode(foreachBlock);
@@ -1793,7 +2308,7 @@ namespace CCSharpCompiler;
         case SyntaxKind.DoStatement:
           //do statement/block while (expression)
           method.Append("do ");
-          StatementNode(GetChildNode(node, 1));
+          LoopBodyNode(GetChildNode(node, 1));
           method.Append(" while (");
           ExpressionNode(GetChildNode(node, 2));
           method.Append(");\r\n");
@@ -1813,51 +2328,55 @@ namespace CCSharpCompiler;
         case SyntaxKind.TryStatement:
           //statement CatchClause ... FinallyClause
           int cnt = GetChildCount(node);
-          bool hasFinally = false;
+          SyntaxNode finallyClause = null;
+          bool hasCatch = false;
           for(int a=2;a<=cnt;a++) {
             SyntaxNode child = GetChildNode(node, a);
             if (child.Kind() == SyntaxKind.FinallyClause) {
-              hasFinally = true;
+              finallyClause = child;
+            } else {
+              hasCatch = true;
             }
           }
-          if (hasFinally) {
-            method.Append("try {");
+          if (finallyClause != null) {
+            //finally runs from a destructor (see Core::$Finally) : on normal exit, return, break and exceptions
+            method.Append("{auto $finally" + cls.finallyCnt++ + " = Core::$finally([&]() ");
+            StatementNode(GetChildNode(finallyClause));
+            method.Append(");\r\n");
+          }
+          if (hasCatch) {
+            method.Append("try ");
           }
-          method.Append("try ");
           SyntaxNode tryBlock = GetChildNode(node, 1);
           if (tryBlock.Kind() == SyntaxKind.Block) {
-            BlockNode(tryBlock, false, hasFinally);
+            BlockNode(tryBlock);
           } else {
             StatementNode(tryBlock);
           }
           for(int a=2;a<=cnt;a++) {
             SyntaxNode child = GetChildNode(node, a);
-            switch (child.Kind()) {
-              case SyntaxKind.CatchClause:
-                int cc = GetChildCount(child);
-                if (cc == 2) {
-                  //catch (Exception ?)
-                  SyntaxNode catchDecl = GetChildNode(child, 1);
-                  method.Append(" catch(");
-                  ExpressionNode(GetChildNode(catchDecl));  //exception type
-                  method.Append(" *");
-                  method.Append(file.model.GetDeclaredSymbol(catchDecl).Name);  //exception variable name
-                  method.Append(")");
-                  SyntaxNode catchBlock = GetChildNode(child, 2);
-                  StatementNode(catchBlock, false, hasFinally);
-                } else {
-                  //catch all
-                  method.Append(" catch (...)");
-                  SyntaxNode catchBlock = GetChildNode(child, 1);
-                  StatementNode(catchBlock, false, hasFinally);
-                }
-                break;
-              case SyntaxKind.FinallyClause:
-                method.Append("} catch(System::FinallyException *$finally" + cls.finallyCnt++ + ") ");
-                StatementNode(GetChildNode(child));
-                break;
+            if (child.Kind() != SyntaxKind.CatchClause) continue;
+            int cc = GetChildCount(child);
+            if (cc == 2) {
+              //catch (Exception ?)
+              SyntaxNode catchDecl = GetChildNode(child, 1);
+              method.Append(" catch(");
+              ExpressionNode(GetChildNode(catchDecl));  //exception type
+              method.Append(" *");
+              method.Append(file.model.GetDeclaredSymbol(catchDecl).Name);  //exception variable name
+              method.Append(")");
+              SyntaxNode catchBlock = GetChildNode(child, 2);
+              StatementNode(catchBlock);
+            } else {
+              //catch all
+              method.Append(" catch (...)");
+              SyntaxNode catchBlock = GetChildNode(child, 1);
+              StatementNode(catchBlock);
             }
           }
+          if (finallyClause != null) {
+            method.Append("}\r\n");
+          }
           break;
         case SyntaxKind.ThrowStatement:
           int tc = GetChildCount(node);
@@ -2008,73 +2527,100 @@ namespace CCSharpCompiler;
       return null;
     }
 
+    /** switch on a String : one GetHashCode() (cached in the String) picks the case by a C++ switch on the hash,
+     * one Equals() against the pooled literal confirms it, then a C++ switch on the section index runs the statements.
+     */
     public void SwitchString(SyntaxNode node) {
       //SwitchStatement -> [SwitchSection -> [CaseSwitchLabel, [Default] ...] [Statements...] ...]
       SyntaxNode var = GetChildNode(node);
       String ssid = "$ss_" + cls.switchStringCnt++;
-      method.Append("bool " + ssid + " = false;\r\n");  //set to true if case block used (else default is used)
-      method.Append("while (true) {\r\n");
-      SyntaxNode defaultSection = null;
+      //hash -> cases (literal, section index)
+      SortedDictionary<int, List<KeyValuePair<String, int>>> buckets = new SortedDictionary<int, List<KeyValuePair<String, int>>>();
+      int nullSection = -1;
+      int sectionIdx = 0;
       foreach(var section in node.ChildNodes()) {
         if (section.Kind() != SyntaxKind.SwitchSection) continue;
-        if (HasDefault(section)) {
-          defaultSection = section;
-        } else {
-          SwitchStringSection(var, section, ssid);
+        foreach(var label in section.ChildNodes()) {
+          if (label.Kind() != SyntaxKind.CaseSwitchLabel) continue;
+          SyntaxNode labelValue = GetChildNode(label);
+          String text = (String)file.model.GetConstantValue(labelValue).Value;
+          if (text == null) {
+            nullSection = sectionIdx;
+            continue;
+          }
+          int hash = StringHash(text);
+          if (!buckets.ContainsKey(hash)) buckets.Add(hash, new List<KeyValuePair<String, int>>());
+          buckets[hash].Add(new KeyValuePair<String, int>(file.GetLiteral(ConstantNode(labelValue)), sectionIdx));
         }
+        sectionIdx++;
       }
-      if (defaultSection != null) {
-        SwitchStringSection(var, defaultSection, ssid);
+      method.Append("{System::String* " + ssid + " = ");
+      ExpressionNode(var);
+      method.Append(";\r\n");
+      method.Append("int32 " + ssid + "$case = " + nullSection + ";\r\n");
+      method.Append("if (" + ssid + " != nullptr) {\r\n");
+      method.Append(ssid + "$case = -1;\r\n");
+      if (buckets.Count > 0) {
+        method.Append("switch (" + ssid + "->GetHashCode()) {\r\n");
+        foreach(var bucket in buckets) {
+          method.Append("case " + (bucket.Key == int.MinValue ? "(-2147483647-1)" : bucket.Key.ToString()) + ":");
+          foreach(var entry in bucket.Value) {
+            method.Append("if (" + ssid + "->Equals(" + entry.Key + ")) " + ssid + "$case = " + entry.Value + "; else ");
+          }
+          method.Append("{}\r\n");
+          method.Append("break;\r\n");
+        }
+        method.Append("}\r\n");
       }
-      method.Append("}\r\n");  //end of while loop
-    }
-
-    public bool HasDefault(SyntaxNode section) {
-      foreach(var child in section.ChildNodes()) {
-        if (child.Kind() == SyntaxKind.DefaultSwitchLabel) return true;
+      method.Append("}\r\n");
+      //C# break leaves this switch like it does the original
+      method.Append("switch (" + ssid + "$case) {\r\n");
+      method.currentSwitch++;
+      method.switchIDs[method.currentSwitch] = method.nextSwitchID++;
+      int caseIdx = 0;
+      sectionIdx = 0;
+      foreach(var section in node.ChildNodes()) {
+        if (section.Kind() != SyntaxKind.SwitchSection) continue;
+        bool block = false;
+        bool labeled = false;
+        foreach(var child in section.ChildNodes()) {
+          switch (child.Kind()) {
+            case SyntaxKind.CaseSwitchLabel:
+              if (!labeled) {
+                method.Append("case " + sectionIdx + ":\r\n");
+                labeled = true;
+              }
+              method.Append("$case_" + method.switchIDs[method.currentSwitch] + "_" + caseIdx++);
+              method.Append(":\r\n");
+              break;
+            case SyntaxKind.DefaultSwitchLabel:
+              method.Append("default:\r\n");
+              method.Append("$default_" + method.switchIDs[method.currentSwitch]);
+              method.Append(":\r\n");
+              break;
+            default:
+              if (!block) {
+                method.Append("{\r\n");
+                block = true;
+              }
+              StatementNode(child);
+              break;
+          }
+        }
+        method.Append("}\r\n");
+        sectionIdx++;
       }
-      return false;
+      method.currentSwitch--;
+      method.Append("}}\r\n");
     }
 
-    public void SwitchStringSection(SyntaxNode var, SyntaxNode section, String ssid) {
-      bool first = true;
-      bool statements = false;
-      foreach(var child in section.ChildNodes()) {
-        switch (child.Kind()) {
-          case SyntaxKind.CaseSwitchLabel:
-            if (first) {
-              method.Append("if (");
-              first = false;
-            } else {
-              method.Append("||");
-            }
-            method.Append("(");
-            ExpressionNode(var);
-            method.Append("->Equals(");
-            ExpressionNode(GetChildNode(child));
-            method.Append("))");
-            break;
-          case SyntaxKind.DefaultSwitchLabel:
-            if (first) {
-              method.Append("if (");
-              first = false;
-            } else {
-              method.Append("||");
-            }
-            method.Append("(!" + ssid + ")");
-            break;
-          default:
-            //statements
-            if (!statements) {
-              method.Append(") {\r\n");
-              method.Append(ssid + " = true;\r\n");
-              statements = true;
-            }
-            StatementNode(child);
-            break;
-        }
+    //same as String.GetHashCode() (corelib/src/System/String.cs)
+    private static int StringHash(String text) {
+      int hash = 0;
+      foreach(char ch in text) {
+        hash = unchecked(hash * 31 + ch);
       }
-      method.Append("}\r\n");  //end of statements
+      return hash;
     }
 
     private int GetNumArgs(SyntaxNode node) {
@@ -2113,7 +2659,7 @@ namespace CCSharpCompiler;
           value += "LL";
           break;
         case "string":
-          value = "u\"" + value.Replace("\0", "\\0").Replace("\r", "\\r").Replace("\n", "\\n").Replace("\t", "\\t") + "\"";
+          value = "u\"" + value.Replace("\\", "\\\\").Replace("\"", "\\\"").Replace("\0", "\\0").Replace("\r", "\\r").Replace("\n", "\\n").Replace("\t", "\\t") + "\"";
           break;
       }
       if (!typeCastEnum) return value;
@@ -2155,10 +2701,38 @@ namespace CCSharpCompiler;
             ExpressionNode(left);
             method.Append("::");
             ExpressionNode(right, true);
+          } else if (IsStructValue(left)) {
+            //struct : member of the value itself (no null check)
+            if (IsInParameter(left) && file.model.GetSymbolInfo(node).Symbol is IMethodSymbol) {
+              //method of an in parameter (const T&) : called on a copy like C# does
+              method.Append("std::decay_t<decltype(");
+              ExpressionNode(left, true);
+              method.Append(")>(");
+              ExpressionNode(left, true);
+              method.Append(").");
+            } else if (left.Kind() == SyntaxKind.IdentifierName) {
+              ExpressionNode(left, true);
+              method.Append(".");
+            } else {
+              method.Append("(");
+              ExpressionNode(left, true);
+              method.Append(").");
+            }
+            ExpressionNode(right, true);
           } else {
-            method.Append("$check(");
-            ExpressionNode(left, true);
-            method.Append(")->");
+            if (!file.checks.IsNonNull(left)) {
+              method.Append("$check(");
+              ExpressionNode(left, true);
+              method.Append(")->");
+            } else if (left.Kind() == SyntaxKind.IdentifierName || left.Kind() == SyntaxKind.ThisExpression) {
+              ExpressionNode(left, true);
+              method.Append("->");
+            } else {
+              method.Append("(");
+              ExpressionNode(left, true);
+              method.Append(")->");
+            }
+            BindExact(node, left);
             ExpressionNode(right, true);
           }
           break;
@@ -2205,9 +2779,7 @@ namespace CCSharpCompiler;
           method.Append("false");
           break;
         case SyntaxKind.StringLiteralExpression:
-          method.Append("Core::utf16ToString(");
-          method.Append(ConstantNode(node));
-          method.Append(")");
+          method.Append(file.GetLiteral(ConstantNode(node)));
           break;
         case SyntaxKind.CharacterLiteralExpression:
           method.Append("(char16)");
@@ -2227,6 +2799,12 @@ namespace CCSharpCompiler;
           SyntaxNode array = GetChildNode(node, 1);
           SyntaxNode index = GetChildNode(node, 2);
           ExpressionNode(array);
+          if (file.checks.IsInBounds(node)) {
+            method.Append("->Array[");
+            ExpressionNode(index);
+            method.Append("]");
+            break;
+          }
           method.Append("->at(");
           ExpressionNode(index);
           method.Append(")");
@@ -2243,10 +2821,13 @@ namespace CCSharpCompiler;
           SyntaxNode addleft = GetChildNode(node, 1);
           SyntaxNode addright = GetChildNode(node, 2);
           if (IsString(addleft) || IsString(addright)) {
-            method.Append("Core::addstr(");
-          } else {
-            method.Append("Core::addnum(");
+            //a + b + c ... : one call that allocates the result once
+            method.Append("Core::concat(");
+            ConcatNode(node);
+            method.Append(")");
+            break;
           }
+          method.Append("Core::addnum(");
           ExpressionNode(addleft);
           method.Append(",");
           switch (GetTypeName(addright)) {
@@ -2301,12 +2882,17 @@ namespace CCSharpCompiler;
         case SyntaxKind.AddAssignmentExpression:
           SyntaxNode addassignleft = GetChildNode(node, 1);
           SyntaxNode addassignright = GetChildNode(node, 2);
-          ExpressionNode(addassignleft, true);
+          bool addassignbarrier = BeginStore(addassignleft, true);
           if (IsString(addassignleft) || IsString(addassignright)) {
-            method.Append("= Core::addstr(");
-          } else {
-            method.Append("= Core::addnum(");
+            method.Append("Core::concat(");
+            ExpressionNode(addassignleft);
+            method.Append(",");
+            ConcatPartNode(addassignright);
+            method.Append(")");
+            EndStore(addassignbarrier);
+            break;
           }
+          method.Append("Core::addnum(");
           ExpressionNode(addassignleft);
           method.Append(",");
           switch (GetTypeName(addassignright)) {
@@ -2318,6 +2904,7 @@ namespace CCSharpCompiler;
           }
           ExpressionNode(addassignright);
           method.Append(")");
+          EndStore(addassignbarrier);
           break;
         case SyntaxKind.SubtractAssignmentExpression:
           BinaryAssignNode(node, "-");
@@ -2337,6 +2924,9 @@ namespace CCSharpCompiler;
         case SyntaxKind.ExclusiveOrAssignmentExpression:
           BinaryAssignNode(node, "^");
           break;
+        case SyntaxKind.CoalesceAssignmentExpression:
+          CoalesceAssignNode(node);
+          break;
         case SyntaxKind.ExclusiveOrExpression:
           BinaryNode(node, "^");
           break;
@@ -2404,7 +2994,11 @@ namespace CCSharpCompiler;
           ExpressionNode(GetChildNode(node));
           break;
         case SyntaxKind.ThisExpression:
-          method.Append("this");
+          if (cls.isStruct && !(node.Parent is MemberAccessExpressionSyntax && ((MemberAccessExpressionSyntax)node.Parent).Expression == node)) {
+            method.Append("(*this)");  //struct value
+          } else {
+            method.Append("this");
+          }
           break;
         case SyntaxKind.PointerIndirectionExpression:
           method.Append("*");
@@ -2465,22 +3059,33 @@ namespace CCSharpCompiler;
           SyntaxNode isObj = GetChildNode(node, 1);
           SyntaxNode isType = GetChildNode(node, 2);
           Type isTypeType = new Type(isType);
+          if (IsExactTest(isObj, isType)) {
+            method.Append("Core::$is_exact<" + isTypeType.GetCPPType() + ">(");
+            ExpressionNode(isObj);
+            method.Append(")");
+            break;
+          }
           ExpressionNode(isObj);
           method.Append("->GetType()");
           method.Append("->IsDerivedFrom(");
           method.Append(isTypeType.GetCoreType());
+          method.Append(")");
           break;
         case SyntaxKind.AsExpression:
           //X as Type
           SyntaxNode asObj = GetChildNode(node, 1);
           SyntaxNode asType = GetChildNode(node, 2);
           Type asTypeType = new Type(asType);
-          method.Append(asTypeType.GetCoreType());
-          method.Append("->IsDerivedFrom(");
-          ExpressionNode(asObj);
-          method.Append("->GetType()) ? dynamic_cast<" + asTypeType.Get_Symbol() + ">(");
+          if (IsExactTest(asObj, asType)) {
+            method.Append("Core::$as_exact<" + asTypeType.GetCPPType() + ">(");
+            ExpressionNode(asObj);
+            method.Append(")");
+            break;
+          }
+          //dynamic_cast returns nullptr if the object is null or not derived from Type
+          method.Append("dynamic_cast<" + asTypeType.GetTypeDeclaration() + ">(");
           ExpressionNode(asObj);
-          method.Append(") : nullptr)");
+          method.Append(")");
           break;
         case SyntaxKind.ConditionalExpression:
           // (cond ? val1 : val2)
@@ -2586,6 +3191,92 @@ namespace CCSharpCompiler;
       return false;
     }
 
+    //reference stored into a heap object (instance field or array element)
+    private bool IsHeapRefStore(SyntaxNode node) {
+      ITypeSymbol type = file.model.GetTypeInfo(node).Type;
+      if (type == null) return false;
+      if (type.TypeKind == TypeKind.Delegate) return false;
+      if (type.TypeKind == TypeKind.Struct) {
+        if (!HasReferences(type)) return false;  //struct copied by value : Core::$wb shades its words
+      } else if (IsPrimitive(type)) {
+        return false;
+      } else if (!type.IsReferenceType && type.TypeKind != TypeKind.TypeParameter) {
+        return false;
+      }
+      if (node.Kind() == SyntaxKind.ElementAccessExpression) return true;
+      ISymbol symbol = file.model.GetSymbolInfo(node).Symbol;
+      if (symbol == null) return false;
+      if (symbol.IsStatic) return false;  //static fields are roots
+      if (symbol.Kind == SymbolKind.Field) return true;
+      if (symbol.Kind == SymbolKind.Property) return IsProperty(node);  //Property<T>.Value
+      if (symbol.Kind == SymbolKind.Parameter) return ((IParameterSymbol)symbol).RefKind != RefKind.None;  //ref may point into the heap
+      return false;
+    }
+
+    /** int, bool, ... : classes in corelib (IsReferenceType) but C++ values. */
+    public static bool IsPrimitive(ITypeSymbol type) {
+      switch (type.SpecialType) {
+        case SpecialType.System_Boolean:
+        case SpecialType.System_Char:
+        case SpecialType.System_SByte:
+        case SpecialType.System_Byte:
+        case SpecialType.System_Int16:
+        case SpecialType.System_UInt16:
+        case SpecialType.System_Int32:
+        case SpecialType.System_UInt32:
+        case SpecialType.System_Int64:
+        case SpecialType.System_UInt64:
+        case SpecialType.System_Single:
+        case SpecialType.System_Double:
+        case SpecialType.System_Void:
+          return true;
+      }
+      return false;
+    }
+
+    //lvalue = ... : with the write barrier for heap references (see IsHeapRefStore), close with EndStore()
+    private bool BeginStore(SyntaxNode left, bool useName = false) {
+      if (IsHeapRefStore(left)) {
+        method.Append("Core::$wb(&(");
+        ExpressionNode(left, useName);
+        method.Append("),");
+        return true;
+      }
+      ExpressionNode(left, useName);
+      method.Append(" = ");
+      return false;
+    }
+
+    private void EndStore(bool barrier) {
+      if (barrier) method.Append(")");
+    }
+
+    //expression of a C# struct type (a C++ value, not a pointer)
+    private bool IsStructValue(SyntaxNode node) {
+      if (node.Kind() == SyntaxKind.ThisExpression) return false;  //this is a pointer in C++
+      ITypeSymbol type = file.model.GetTypeInfo(node).Type;
+      return type != null && type.TypeKind == TypeKind.Struct;
+    }
+
+    private bool IsInParameter(SyntaxNode node) {
+      IParameterSymbol symbol = file.model.GetSymbolInfo(node).Symbol as IParameterSymbol;
+      return symbol != null && symbol.RefKind == RefKind.In;
+    }
+
+    /** Struct with reference fields (directly or in nested struct fields). */
+    public static bool HasReferences(ITypeSymbol type) {
+      if (type == null) return false;
+      foreach(var member in type.GetMembers()) {
+        IFieldSymbol field = member as IFieldSymbol;
+        if (field == null || field.IsStatic || field.IsConst) continue;
+        ITypeSymbol ftype = field.Type;
+        if (IsPrimitive(ftype)) continue;
+        if (ftype.IsReferenceType || ftype.TypeKind == TypeKind.TypeParameter || ftype.TypeKind == TypeKind.Pointer) return true;
+        if (ftype.TypeKind == TypeKind.Struct && !SymbolEqualityComparer.Default.Equals(ftype, type) && HasReferences(ftype)) return true;
+      }
+      return false;
+    }
+
     private bool IsExtern(SyntaxNode node) {
       ISymbol symbol = file.model.GetSymbolInfo(node).Symbol;
       if (symbol == null) return symbol.IsExtern;
@@ -2618,6 +3309,33 @@ namespace CCSharpCompiler;
       return symbol.Kind == SymbolKind.Namespace;
     }
 
+    //operands of a string concatenation chain (see Core::concat)
+    private void ConcatNode(SyntaxNode node) {
+      ConcatPartNode(GetChildNode(node, 1));
+      method.Append(",");
+      ConcatPartNode(GetChildNode(node, 2));
+    }
+
+    private void ConcatPartNode(SyntaxNode node) {
+      SyntaxNode inner = node;
+      while (inner.Kind() == SyntaxKind.ParenthesizedExpression) {
+        inner = GetChildNode(inner);
+      }
+      if (inner.Kind() == SyntaxKind.AddExpression && IsString(inner)) {
+        //nested string concatenation : flatten into the same call
+        ConcatNode(inner);
+        return;
+      }
+      switch (GetTypeName(node)) {
+        case "char": method.Append("(char16)"); break;
+        case "short": method.Append("(int32)"); break;
+        case "ushort": method.Append("(uint32)"); break;
+        case "byte": method.Append("(uint32)"); break;
+        case "sbyte": method.Append("(int32)"); break;
+      }
+      ExpressionNode(node);
+    }
+
     private bool IsString(SyntaxNode node) {
       ITypeSymbol type = file.model.GetTypeInfo(node).Type;
       if (type == null) return false;
@@ -2715,11 +3433,26 @@ namespace CCSharpCompiler;
     }
 
     private void BinaryAssignNode(SyntaxNode node, string op) {
-      ExpressionNode(GetChildNode(node, 1), true);
-      method.Append(" = ");
+      bool barrier = BeginStore(GetChildNode(node, 1), true);
       ExpressionNode(GetChildNode(node, 1));
       method.Append(op);
       ExpressionNode(GetChildNode(node, 2));
+      EndStore(barrier);
+    }
+
+    //a ??= b : stores b only when a is null
+    private void CoalesceAssignNode(SyntaxNode node) {
+      SyntaxNode left = GetChildNode(node, 1);
+      SyntaxNode right = GetChildNode(node, 2);
+      method.Append("(");
+      ExpressionNode(left);
+      method.Append(" == nullptr ? (");
+      bool barrier = BeginStore(left);
+      ExpressionNode(right);
+      EndStore(barrier);
+      method.Append(") : ");
+      ExpressionNode(left);
+      method.Append(")");
     }
 
     private String GetModType(SyntaxNode left, SyntaxNode right) {
@@ -2749,14 +3482,15 @@ namespace CCSharpCompiler;
     private void ModAssignNode(SyntaxNode node, string op) {
       SyntaxNode left = GetChildNode(node, 1);
       SyntaxNode right = GetChildNode(node, 2);
-      ExpressionNode(left, true);
-      method.Append("= Core::mod");
+      bool barrier = BeginStore(left, true);
+      method.Append("Core::mod");
       method.Append(GetModType(left, right));
       method.Append("(");
       ExpressionNode(left);
       method.Append(",");
       ExpressionNode(right);
       method.Append(")");
+      EndStore(barrier);
     }
 
     private void CastNode(SyntaxNode node) {
@@ -2767,7 +3501,11 @@ namespace CCSharpCompiler;
       //C++ dynamic_cast<type>(value)
       Type type = new Type(castType);
       String typestr = type.GetTypeDeclaration();
-      if (type.isObject) {
+      if (type.isObject && type.arrays == 0 && IsExactTest(value, castType)) {
+        method.Append("Core::$as_exact<" + type.GetCPPType() + ">(");
+        ExpressionNode(value);
+        method.Append(")");
+      } else if (type.isObject) {
         method.Append("dynamic_cast<");
         method.Append(typestr);
         method.Append(">");
@@ -2848,6 +3586,13 @@ namespace CCSharpCompiler;
       //lvalue = rvalue
       SyntaxNode left = GetChildNode(node, 1);
       SyntaxNode right = GetChildNode(node, 2);
+      if (IsHeapRefStore(left)) {
+        //write barrier (see Core::$wb)
+        bool barrier = BeginStore(left);
+        ExpressionNode(right);
+        EndStore(barrier);
+        return;
+      }
       ExpressionNode(left);
       method.Append(" = ");
       if (false && IsMethod(right)) {
@@ -2872,22 +3617,72 @@ namespace CCSharpCompiler;
       }
     }
 
+    //foreach over contiguous storage : {count, storage} members of the collection (null if it needs an enumerator)
+    private string[] GetIndexedForEach(SyntaxNode node) {
+      ITypeSymbol type = file.model.GetTypeInfo(node).Type;
+      if (type == null) return null;
+      if (type.TypeKind == TypeKind.Array) {
+        return ((IArrayTypeSymbol)type).Rank == 1 ? new string[] {"Length", ""} : null;
+      }
+      if (type.SpecialType == SpecialType.System_String) return new string[] {"Value->Length", "->Value"};
+      switch (type.OriginalDefinition.ToString()) {
+        case "System.Array<T>": return new string[] {"Length", "->Elements"};
+        case "System.List<T>": return new string[] {"Length", "->Items"};
+      }
+      return null;
+    }
+
+    //System.Array.Copy<T>() : bulk copy (see Core::$arraycopy)
+    private bool IsArrayCopy(SyntaxNode node) {
+      IMethodSymbol symbol = file.model.GetSymbolInfo(node).Symbol as IMethodSymbol;
+      if (symbol == null || !symbol.IsStatic) return false;
+      return symbol.Name == "Copy" && symbol.ContainingType.ToString() == "System.Array";
+    }
+
     private void InvokeNode(SyntaxNode node, bool New = false) {
       //IdentifierName/SimpleMemberAccessExpression/QualifiedName, ArgumentList
       SyntaxNode id = GetChildNode(node, 1);
       SyntaxNode args = GetChildNode(node, 2);
-      if (New) {
+      if (!New && IsArrayCopy(node)) {
+        method.Append("Core::$arraycopy(");
+        OutArgList(args);
+        method.Append(")");
+        return;
+      }
+      bool heap = New && !IsStructValue(node);  //new struct : constructed in place (stack, field or array element)
+      if (heap) {
         method.Append("(new ");
       }
       ExpressionNode(id, !New);
       method.Append("(");
       OutArgList(args);
       method.Append(")");
-      if (New) {
+      if (heap) {
         method.Append(")");
       }
     }
 
+    //x.M() on a receiver that always holds a new T() : T::M() is bound at compile time instead of a virtual call
+    private void BindExact(SyntaxNode node, SyntaxNode left) {
+      if (node.Parent.Kind() != SyntaxKind.InvocationExpression || GetChildNode(node.Parent) != node) return;
+      IMethodSymbol symbol = file.model.GetSymbolInfo(node).Symbol as IMethodSymbol;
+      if (symbol == null || symbol.MethodKind != MethodKind.Ordinary || symbol.IsGenericMethod) return;
+      if (!(symbol.IsVirtual || symbol.IsOverride || symbol.IsAbstract) || Hierarchy.IsFinal(symbol)) return;
+      ObjectCreationExpressionSyntax creation = file.checks.ExactType(left);
+      if (creation == null) return;
+      method.Append(new Type(creation.Type).GetCPPType());
+      method.Append("::");
+    }
+
+    //obj is/as T where T has no subclasses (see Core::$is_exact) : obj must be a class so static_cast can convert it
+    private bool IsExactTest(SyntaxNode obj, SyntaxNode type) {
+      ITypeSymbol objType = file.model.GetTypeInfo(obj).Type;
+      if (objType == null || objType.TypeKind != TypeKind.Class) return false;
+      INamedTypeSymbol target = file.model.GetTypeInfo(type).Type as INamedTypeSymbol;
+      if (target == null || target.IsGenericType || target.ContainingType != null) return false;
+      return Hierarchy.IsLeaf(target);
+    }
+
     //ArgumentList
     private void OutArgList(SyntaxNode node) {
       IEnumerable<SyntaxNode> nodes = node.ChildNodes();
@@ -3027,6 +3822,7 @@ namespace CCSharpCompiler;
     public string nsfullname = "";  //namespace + fullname
     public bool hasctor;
     public bool isInterface;
+    public bool isStruct;  //value type : no System::Object base, no vtable of its own
     public SyntaxNode node;
     public SemanticModel model;
     public List<Type> bases = new List<Type>();
@@ -3182,7 +3978,7 @@ namespace CCSharpCompiler;
           }
         }
       }
-      if (_new == null || isAbstract) {
+      if (_new == null || isAbstract || isStruct) {
         sb.Append(",[] () {return nullptr;}");
       } else {
         sb.Append(",[] () {return new " + this.Namespace + "::" + this.fullname + "();}");
@@ -3211,6 +4007,7 @@ namespace CCSharpCompiler;
       }
       if (name != fullname) sb.Append(GetFlags(true, false));  //inner class
       sb.Append(" struct " + name);
+      if (!isInterface && node != null && Hierarchy.IsLeaf(model.GetDeclaredSymbol(node) as INamedTypeSymbol)) sb.Append(" final");
       if (bases.Count > 0 || cppbases.Count > 0 || ifaces.Count > 0) {
         sb.Append(":");
         first = true;
@@ -3279,6 +4076,7 @@ namespace CCSharpCompiler;
         if (isGeneric || method.isGeneric) {
           if (method.name == "$init") {
             sb.Append("{\r\n");
+            if (HasDestructor()) sb.Append("Core::$gc_finalizable(this);\r\n");  //only registered objects are finalized
             foreach(var field in fields) {
               foreach(var v in field.variables) {
                 if (v.method.Length() > 0 && !field.isStatic) {
@@ -3293,13 +4091,25 @@ namespace CCSharpCompiler;
         }
         sb.Append(";\r\n");
       }
+      if (isStruct && fields.Exists(f => f.isProperty)) {
+        //Property<T> is bound to this : a copy binds its own properties ($init) and copies the values
+        sb.Append(name + "(const " + name + "& $o) {$init(); *this = $o;}\r\n");
+        sb.Append(name + "& operator=(const " + name + "& $o) {");
+        foreach(var field in fields) {
+          if (field.isStatic) continue;
+          foreach(var v in field.variables) {
+            sb.Append(v.name + (field.isProperty ? ".Value = $o." + v.name + ".Value;" : " = $o." + v.name + ";"));
+          }
+        }
+        sb.Append("return *this;}\r\n");
+      }
       if (!isInterface) {
         sb.Append("static System::Type* $GetType()");
         if (isGeneric) {
           sb.Append("{return &Core::Type_" + full_name + ";}\r\n");
         }
         sb.Append(";\r\n");
-        if (nsfullname != "System::Object") {
+        if (nsfullname != "System::Object" && !isStruct) {
           sb.Append("virtual System::Type* GetType()");
           if (isGeneric) {
             sb.Append("{ return $GetType(); }");
@@ -3378,6 +4188,98 @@ namespace CCSharpCompiler;
       GetInnerStaticFieldsInit(sb);
       return sb.ToString();
     }
+    /** Registers offsets of reference fields with the GC so objects are scanned precisely.
+     * Classes the compiler can not describe are not registered and are scanned conservatively. */
+    public string GetLayoutInit() {
+      StringBuilder sb = new StringBuilder();
+      bool precise = !isInterface && !isGeneric && cppbases.Count == 0 && (isStruct || (bases.Count > 0 && !bases[0].isGeneric));
+      for(Class o = outter; o != null; o = o.outter) {
+        if (o.isGeneric) precise = false;
+      }
+      List<String> offsets = new List<String>();
+      if (precise && isStruct) {
+        //T[] stores the structs inline : the reference words of one element repeat over the array
+        if (AddStructOffsets(model.GetDeclaredSymbol(node) as ITypeSymbol, "", offsets)) {
+          sb.Append("{");
+          if (offsets.Count > 0) {
+            sb.Append("static int32 offsets[] = {" + String.Join(",", offsets) + "};");
+          } else {
+            sb.Append("int32 *offsets = nullptr;");
+          }
+          sb.Append("Core::$gc_array_layout<" + nsfullname + ">(offsets," + offsets.Count + ");");
+          sb.Append("}\r\n");
+        }
+        precise = false;
+      }
+      if (precise) {
+        foreach(var field in fields) {
+          if (field.isStatic) continue;
+          if (field.isProperty || field.isDelegate) {
+            precise = false;  //unknown layout
+            break;
+          }
+          if (field.isStruct && !field.isArray) {
+            //struct stored inline : its reference words
+            foreach(var v in field.variables) {
+              if (!AddStructOffsets(field.typeSymbol, "offsetof(" + nsfullname + "," + v.name + ")", offsets)) precise = false;
+            }
+            continue;
+          }
+          if (!field.isObject && !field.isArray && !field.isPtr) continue;
+          foreach(var v in field.variables) {
+            offsets.Add("offsetof(" + nsfullname + "," + v.name + ")");
+          }
+        }
+      }
+      if (precise) {
+        String baseType = "nullptr";
+        if (bases[0].GetSymbol() != "Core::Object") {
+          baseType = "(void*)&typeid(" + bases[0].GetSymbol() + ")";
+        }
+        sb.Append("{");
+        if (offsets.Count > 0) {
+          sb.Append("static int32 offsets[] = {" + String.Join(",", offsets) + "};");
+        } else {
+          sb.Append("int32 *offsets = nullptr;");
+        }
+        sb.Append("Core::Heap::AddLayout((void*)&typeid(" + nsfullname + ")," + baseType + ",sizeof(" + nsfullname + "),offsets," + offsets.Count + "," + (HasDestructor() ? "true" : "false") + ");");
+        sb.Append("}\r\n");
+      }
+      foreach(var inner in inners) {
+        sb.Append(inner.GetLayoutInit());
+      }
+      return sb.ToString();
+    }
+    //offsets of the reference words of a struct stored at offset (false if its layout is unknown : generic, properties, delegates)
+    private static bool AddStructOffsets(ITypeSymbol type, String offset, List<String> offsets) {
+      INamedTypeSymbol named = type as INamedTypeSymbol;
+      if (named == null || named.IsGenericType) return false;
+      String name = Generate.ConvertName(named.ToString().Replace(".", "::"));
+      foreach(var member in named.GetMembers()) {
+        if (member.IsStatic) continue;
+        if (member.Kind == SymbolKind.Property) return false;
+        IFieldSymbol field = member as IFieldSymbol;
+        if (field == null || field.IsConst || field.IsImplicitlyDeclared) continue;
+        ITypeSymbol ftype = field.Type;
+        if (ftype.TypeKind == TypeKind.Delegate) return false;
+        String at = (offset.Length > 0 ? offset + "+" : "") + "offsetof(" + name + "," + Generate.ConvertName(field.Name) + ")";
+        if (Generate.IsPrimitive(ftype)) continue;
+        if (ftype.IsReferenceType || ftype.TypeKind == TypeKind.Pointer) {
+          offsets.Add(at);
+        } else if (ftype.TypeKind == TypeKind.Struct) {
+          if (!AddStructOffsets(ftype, at, offsets)) return false;
+        } else if (ftype.TypeKind == TypeKind.TypeParameter) {
+          return false;
+        }
+      }
+      return true;
+    }
+    public bool HasDestructor() {
+      foreach(Method m in methods) {
+        if (m.name.StartsWith("~")) return true;
+      }
+      return false;
+    }
     public string GetMethodsDefinitions() {
       StringBuilder sb = new StringBuilder();
       foreach(var method in methods) {
@@ -3410,6 +4312,7 @@ namespace CCSharpCompiler;
         if (method.Length() == 0) method.Append("{}\r\n");
         if (method.name == "$init") {
           sb.Append("{\r\n");
+          if (method.cls.HasDestructor()) sb.Append("Core::$gc_finalizable(this);\r\n");  //only registered objects are finalized
           foreach(var field in method.cls.fields) {
             foreach(var v in field.variables) {
               if (v.method.Length() > 0 && !field.isStatic) {
@@ -3428,9 +4331,11 @@ namespace CCSharpCompiler;
       if (!isInterface) {
         String full_name = FullName(Namespace, fullname);
         //virtual GetType()
-        sb.Append("System::Type* " + fullname + "::GetType() {");
-        sb.Append("  return &Core::Type_" + full_name + ";\r\n");
-        sb.Append("}\r\n");
+        if (!isStruct) {
+          sb.Append("System::Type* " + fullname + "::GetType() {");
+          sb.Append("  return &Core::Type_" + full_name + ";\r\n");
+          sb.Append("}\r\n");
+        }
         //static GetType()
         sb.Append("System::Type* " + fullname + "::$GetType() {");
         sb.Append("  return &Core::Type_" + full_name + ";\r\n");
@@ -3470,6 +4375,7 @@ namespace CCSharpCompiler;
     public bool isArray;
     public int arrays;  //# of dimensions
     public bool isObject;
+    public bool isStruct;  //C# struct : C++ value type (arrays of structs store the elements inline)
     public bool isDelegate;
     public bool isPtr;  //unsafe pointer
     public int ptrs;
@@ -3502,6 +4408,7 @@ namespace CCSharpCompiler;
       isArray = src.isArray;
       arrays = src.arrays;
       isObject = src.isObject;
+      isStruct = src.isStruct;
       isPtr = src.isPtr;
       ptrs = src.ptrs;
       cls = src.cls;
@@ -3694,6 +4601,7 @@ namespace CCSharpCompiler;
             case TypeKind.Delegate: isObject = false; break;
             case TypeKind.Enum: isObject = false; break;
             case TypeKind.TypeParameter: isObject = false; break;
+            case TypeKind.Struct: isObject = false; isStruct = true; break;
           }
           if (node != null) {
             switch (node.Kind()) {
@@ -3801,6 +4709,7 @@ namespace CCSharpCompiler;
   class Argument {
     public Type type;
     public Variable name = new Variable();
+    public RefKind refKind;  //ref / out : T& , in : const T&
   }
 
   class Field : Type
@@ -3838,6 +4747,8 @@ namespace CCSharpCompiler;
         if (!isStatic && !isProperty && !isDelegate) {
           if (isObject) {
             sb.Append(" = nullptr");
+          } else if (isStruct && !isArray) {
+            sb.Append(" = {}");
           } else {
             sb.Append(" = 0");
           }
@@ -3879,7 +4790,9 @@ namespace CCSharpCompiler;
       bool first = true;
       foreach(var arg in args) {
         if (!first) sb.Append(","); else first = false;
+        if (arg.refKind == RefKind.In) sb.Append("const ");
         sb.Append(arg.type.GetTypeDeclaration());
+        if (arg.refKind != RefKind.None) sb.Append("&");
         sb.Append(" ");
         sb.Append(arg.name.name);
         if (decl && arg.name.method.src.Length > 0) {
@@ -3922,6 +4835,7 @@ namespace CCSharpCompiler;
       if (isOperator) sb.Append(" operator");
       if (!isDelegate) sb.Append(name);
       sb.Append(GetArgs(true));
+      if (!isDelegate && !isOperator && Hierarchy.IsFinal(symbol)) sb.Append(" final");
       if (isDelegate) {
         sb.Append(">");  //$delegate");
         sb.Append(name);
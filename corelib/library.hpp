@@ -0,0 +1,210 @@
+#include <type_traits>
+#include <atomic>
+#include <cstring>
+#include <cstddef>
+#include <typeinfo>
+
+namespace Core {
+  extern volatile bool $gc_marking;
+  extern uint8** $gc_cards;
+  extern volatile bool $gc_safepoint;
+  void $gc_shade(void* ptr);
+  void $gc_finalizable(void* obj);
+  void $gc_add_array_layout(void* type, int32 lengthOffset, int32 dataOffset, int32 elemSize, int32* offsets, int32 count);
+  void $gc_poll_slow();
+  void $gc_enter_native();
+  void $gc_leave_native();
+
+  /** Safepoint poll : generated at method entry and loop back-edges. */
+  inline void $gc_poll() {
+    if ($gc_safepoint) $gc_poll_slow();
+  }
+
+  /** Scope of a blocking native call (lock, wait, I/O) : the collector does not wait for the thread to reach a safepoint.
+   * No references may be stored into the heap inside the scope.
+   */
+  struct $GCNative {
+    $GCNative() {$gc_enter_native();}
+    ~$GCNative() {$gc_leave_native();}
+  };
+
+  /** try { } finally { } : the compiler passes the finally block as a lambda that runs when the holder leaves scope
+   * (normal exit, return, break, continue and exceptions).
+   * An exception thrown by the finally block propagates, unless the scope is already being left by an exception :
+   * C++ can not throw during unwinding, that calls std::terminate.
+   */
+  template<typename F>
+  struct $Finally {
+    F block;
+    ~$Finally() noexcept(false) {block();}
+  };
+
+  template<typename F>
+  inline $Finally<F> $finally(F block) {
+    return $Finally<F>{block};
+  }
+
+  /** Marks the card (page) holding a slot dirty so the next minor collection scans it.
+   * Slot addresses are decoded the same way as heap pointers (chain + page), other addresses are ignored.
+   */
+  inline void $gc_card(void* slot) {
+    uint64 a = (uint64)slot;
+    if ((a & 0xffff00ff00000000ULL) != 0) return;
+    uint64 chain = (a >> 40) - 1;
+    if (chain >= 60) return;  //NUM_CHAINS
+    uint64 page = (a >> 12) & 0xfffff;
+    uint8* cards = $gc_cards[chain * 1024 + (page >> 10)];
+    if (cards != nullptr) cards[page & 1023] = 1;
+  }
+
+  /** Write barrier : stores a reference into a heap object (field, array element).
+   * While the collector is marking concurrently the stored reference is recorded so it can not be missed.
+   * With generational collection enabled the card holding the slot is dirtied.
+   * A C# struct with reference fields is stored by value : every word is shaded (non references are ignored by the collector)
+   * and the cards of both ends are dirtied.
+   */
+  template<typename T, typename V>
+  inline T $wb(T* slot, V value) {
+    T v = value;
+    *slot = v;
+    if constexpr (std::is_pointer<T>::value) {
+      if ($gc_marking) $gc_shade((void*)v);
+      if ($gc_cards != nullptr) $gc_card((void*)slot);
+    } else if constexpr (std::is_class<T>::value) {
+      if ($gc_marking) {
+        void** words = (void**)slot;
+        for(size_t i=0;i<sizeof(T) / sizeof(void*);i++) {
+          if (words[i] != nullptr) $gc_shade(words[i]);
+        }
+      }
+      if ($gc_cards != nullptr) {
+        $gc_card((void*)slot);
+        $gc_card((void*)((uint8*)slot + sizeof(T) - 1));
+      }
+    }
+    return v;
+  }
+
+  /** Atomic view of a field or array element (used by native code : C# has no atomic types). */
+  template<typename T>
+  inline std::atomic<T>* $atomic(T* slot) {
+    return reinterpret_cast<std::atomic<T>*>(slot);
+  }
+
+  /** Atomic compare and swap of a reference with the write barrier. */
+  template<typename T>
+  inline bool $cas(T* slot, T expected, T value) {
+    if (!$atomic(slot)->compare_exchange_strong(expected, value)) return false;
+    if ($gc_marking) $gc_shade((void*)value);
+    if ($gc_cards != nullptr) $gc_card((void*)slot);
+    return true;
+  }
+
+  /** Atomic exchange of a reference with the write barrier. */
+  template<typename T>
+  inline T $xchg(T* slot, T value) {
+    T old = $atomic(slot)->exchange(value);
+    if ($gc_marking) $gc_shade((void*)value);
+    if ($gc_cards != nullptr) $gc_card((void*)slot);
+    return old;
+  }
+
+  /** obj is T for a class T without subclasses (sealed or a leaf of the whole program, see the compiler's Hierarchy) :
+   * the object's vptr is compared with the vptr of T seen through an O* (one load and one pointer compare, no virtual call)
+   * instead of GetType()->IsDerivedFrom() and dynamic_cast.
+   * The vptr of T is learned from the first object that typeid() confirms (a T from another module only takes the typeid path).
+   */
+  template<typename T, typename O>
+  inline bool $is_exact(O* obj) {
+    static std::atomic<void*> exact{nullptr};
+    if (obj == nullptr) return false;
+    void* vptr = *(void**)obj;
+    if (vptr == exact.load(std::memory_order_relaxed)) return true;
+    if (typeid(*obj) != typeid(T)) return false;
+    exact.store(vptr, std::memory_order_relaxed);
+    return true;
+  }
+
+  /** obj as T / (T)obj for a class T without subclasses. */
+  template<typename T, typename O>
+  inline T* $as_exact(O* obj) {
+    return $is_exact<T>(obj) ? static_cast<T*>(obj) : nullptr;
+  }
+
+  /** System.Array.Copy() : the compiler calls this for every Array.Copy<T>().
+   * Clamps the range like Array.Copy, overlapping ranges are allowed (memmove).
+   * A reference (or struct) array gets the write barrier once for the whole range instead of per element.
+   */
+  template<typename T>
+  inline void $arraycopy(FixedArray$T<T>* src, int32 srcOff, FixedArray$T<T>* dst, int32 dstOff, int32 length) {
+    if (src == nullptr || dst == nullptr) return;
+    if (srcOff < 0 || dstOff < 0 || srcOff >= src->Length || dstOff >= dst->Length) return;
+    if (srcOff + length > src->Length) length = src->Length - srcOff;
+    if (dstOff + length > dst->Length) length = dst->Length - dstOff;
+    if (length <= 0) return;
+    T* to = &dst->Array[dstOff];
+    std::memmove((void*)to, (void*)&src->Array[srcOff], (size_t)length * sizeof(T));
+    if constexpr (std::is_pointer<T>::value || std::is_class<T>::value) {
+      if ($gc_marking) {
+        //struct elements : every word is shaded like Core::$wb does (non references are ignored by the collector)
+        void** words = (void**)to;
+        size_t count = (size_t)length * sizeof(T) / sizeof(void*);
+        for(size_t i=0;i<count;i++) {
+          if (words[i] != nullptr) $gc_shade(words[i]);
+        }
+      }
+      if ($gc_cards != nullptr) {
+        uint8* end = (uint8*)(to + length);
+        for(uint8* p = (uint8*)to;p < end;p += 4096) {
+          $gc_card((void*)p);
+        }
+        $gc_card((void*)(end - 1));
+      }
+    }
+  }
+
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winvalid-offsetof"  //FixedArray$T has a vtable (offsets are still fixed)
+#endif
+  /** Registers the reference fields of a C# struct T (offsets in T) so a T[] is scanned precisely :
+   * the elements are stored inline and only their reference words are visited (count = 0 : the array is not scanned).
+   */
+  template<typename T>
+  inline void $gc_array_layout(int32* offsets, int32 count) {
+    typedef FixedArray$T<T> A;
+    static_assert(!std::is_pointer<decltype(A::Array)>::value, "struct array elements must be stored inline");
+    $gc_add_array_layout((void*)&typeid(A), (int32)offsetof(A, Length), (int32)offsetof(A, Array), (int32)sizeof(T), offsets, count);
+  }
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
+  /** One operand of a string concatenation (see Core::concat) : numbers are formatted into buf, strings are not copied. */
+  struct $StrPart {
+    System::String* str;  //keeps a ToString() result alive
+    const char16* chars;
+    int32 length;
+    char16 buf[32];
+    $StrPart(std::nullptr_t) : str(nullptr), chars(buf), length(0) {}
+    $StrPart(System::String* s);
+    $StrPart(System::Object* o);  //o->ToString()
+    $StrPart(int32 v) : $StrPart((int64)v) {}
+    $StrPart(uint32 v) : $StrPart((uint64)v) {}
+    $StrPart(int64 v);
+    $StrPart(uint64 v);
+    $StrPart(char16 ch) : str(nullptr), chars(buf), length(1) {buf[0] = ch;}
+    $StrPart(bool b);
+  };
+  System::String* $concat(const $StrPart* parts, int32 count);
+
+  /** String concatenation : the compiler flattens a + b + c ... into one call, the result is sized once and allocated once. */
+  template<typename... A>
+  inline System::String* concat(const A&... args) {
+    const $StrPart parts[] = {$StrPart(args)...};
+    return $concat(parts, (int32)sizeof...(A));
+  }
+
+  /** Interned string for a literal in native code : created on first use, slot is a static that becomes a GC root. */
+  System::String* $literal(System::String** slot, const char16_t* text);
+}
@@ -0,0 +1,7 @@
+namespace Core {
+  public class Heap {
+    /** Registers offsets of reference fields for a type (called by generated library init code).
+     * Objects of types without a destructor (in the type or any base) are freed without being finalized. */
+    public extern static unsafe void AddLayout(void* type, void* baseType, int size, int* offsets, int count, bool destructor);
+  }
+}
@@ -3,12 +3,15 @@ using System;
 namespace Core {
   public class OS {
     public extern static void ThreadInit(Thread thread);
-    public extern static void ThreadSuspend(Thread thread);
-    public extern static void ThreadResume(Thread thread);
     public extern static void ThreadGetHandle(Thread thread);
-    public extern static int GetThreadContextCount();
-    public extern static unsafe void GetThreadContext(Thread thread, void** context);
+    public extern static int GetRegisterCount();
+    public extern static unsafe void SaveRegisters(void** regs);  //saves registers of current thread (see Object.cpp safepoints)
     public extern static int AllocateVirtualPages(int chain,int page,int cnt);
+    public extern static void FreeVirtualPages(int chain,int page,int cnt);
+    public extern static void DecommitVirtualPages(int chain,int page,int cnt);
+    public extern static void CommitVirtualPages(int chain,int page,int cnt);
+    public extern static unsafe void FutexWait(int* addr, int value);  //sleeps while *addr == value (may return early)
+    public extern static unsafe void FutexWake(int* addr, int count);  //wakes up to count threads sleeping on addr
     public extern static void ConsoleEnable();
     public extern static void ConsoleDisable();
     public extern static int ConsoleWidth();
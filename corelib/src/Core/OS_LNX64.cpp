@@ -1,8 +1,9 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <pthread.h>
-#include <signal.h>
 #include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 #define PAGE_SIZE 0x1000
 
@@ -10,48 +11,42 @@ void Core::OS::ThreadGetHandle(System::Thread* thread) {
   thread->NativeHandle = (void*)pthread_self();
 }
 
-int Core::OS::GetThreadContextCount() {
-  return 0;
-}
+#define GC_REGS 12
 
-void Core::OS::GetThreadContext(System::Thread *thread, void** context) {
-  //not needed for Linux - signal will pushaq
+int Core::OS::GetRegisterCount() {
+  return GC_REGS;
 }
 
-static void cb_sig(int signal)
-{
-  void* local = nullptr;
-  System::Thread *thread = System::Thread::Current();
-  thread->StackCurrent = &local;
-  switch(signal) {
-  case SIGUSR1:
-    //Warning : if something else wakes the thread it could corrupt the GC operation
-    pause();
-    break;
-  case SIGUSR2:
-    break;
-  }
+__attribute__((noinline)) void Core::OS::SaveRegisters(void** regs) {
+  //callee saved registers (all others are on the stack of the caller)
+  //must not be inlined : registers still hold the values of the caller
+#if defined(__x86_64__)
+  __asm__ volatile (
+    "movq %%rbx, 0(%0)\n"
+    "movq %%rbp, 8(%0)\n"
+    "movq %%r12, 16(%0)\n"
+    "movq %%r13, 24(%0)\n"
+    "movq %%r14, 32(%0)\n"
+    "movq %%r15, 40(%0)\n"
+    : : "D"(regs) : "memory");
+  for(int a=6;a<GC_REGS;a++) regs[a] = nullptr;
+#elif defined(__aarch64__)
+  __asm__ volatile (
+    "stp x19, x20, [%0, #0]\n"
+    "stp x21, x22, [%0, #16]\n"
+    "stp x23, x24, [%0, #32]\n"
+    "stp x25, x26, [%0, #48]\n"
+    "stp x27, x28, [%0, #64]\n"
+    "str x29, [%0, #80]\n"
+    : : "r"(regs) : "memory");
+  regs[11] = nullptr;
+#else
+#error SaveRegisters() not implemented for this CPU
+#endif
 }
 
 void Core::OS::ThreadInit(System::Thread *thread) {
-  //setup signal handler (invoked inside new thread before it's added to GC thread list)
-  //see https://stackoverflow.com/questions/11468333/linux-threads-suspend-resume
-  struct sigaction act;
-  sigemptyset(&act.sa_mask);
-  act.sa_flags = 0;
-  act.sa_handler = cb_sig;
-  if (sigaction(SIGUSR1, &act, NULL) == -1) printf("Error:unable to handle siguser1\n");
-  if (sigaction(SIGUSR2, &act, NULL) == -1) printf("Error:unable to handle siguser2\n");
-}
-
-void Core::OS::ThreadSuspend(System::Thread *thread) {
-  pthread_t *p_thread = (pthread_t*)thread->NativeHandle;
-  pthread_kill(*p_thread, SIGUSR1);
-}
-
-void Core::OS::ThreadResume(System::Thread *thread) {
-  pthread_t *p_thread = (pthread_t*)thread->NativeHandle;
-  pthread_kill(*p_thread, SIGUSR2);
+  //nothing needed for Linux (threads stop at safepoints)
 }
 
 union uptr {
@@ -62,22 +57,54 @@ union uptr {
 int Core::OS::AllocateVirtualPages(int chain, int page, int cnt) {
   //mmap(void *addr, size_t length, int prot, int flags, int fd, off_t offset);
   //  prot = PROT_READ | PROT_WRITE
-  //  flags = MAP_ANONYMOUS
+  //  flags = MAP_PRIVATE | MAP_ANONYMOUS
   //  fd = -1
   //  offset = 0
   uptr ptr;
   ptr.vptr = nullptr;
   ptr.v64 = chain;
   ptr.v64 <<= 40;
-  ptr.v64 += (page << 12);
+  ptr.v64 += ((int64)page << 12);
   do {
-    void* vptr = mmap(ptr.vptr, cnt * PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_ANONYMOUS, -1, 0);
+    void* vptr = mmap(ptr.vptr, (size_t)cnt * PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
     if (vptr == ptr.vptr) return page;
+    if (vptr != MAP_FAILED) munmap(vptr, (size_t)cnt * PAGE_SIZE);  //address hint was not used
     ptr.v64 += PAGE_SIZE;
     page++;
     if (page == 0x100000) {
       printf("Error:No more memory pages available for chain %d\n", chain);
-      std:exit(1);
+      std::exit(1);
     }
   } while (true);
 }
+
+void Core::OS::FreeVirtualPages(int chain, int page, int cnt) {
+  uptr ptr;
+  ptr.vptr = nullptr;
+  ptr.v64 = chain;
+  ptr.v64 <<= 40;
+  ptr.v64 += ((int64)page << 12);
+  munmap(ptr.vptr, (size_t)cnt * PAGE_SIZE);
+}
+
+void Core::OS::DecommitVirtualPages(int chain, int page, int cnt) {
+  //pages stay mapped and read as zero when touched again
+  uptr ptr;
+  ptr.vptr = nullptr;
+  ptr.v64 = chain;
+  ptr.v64 <<= 40;
+  ptr.v64 += ((int64)page << 12);
+  madvise(ptr.vptr, (size_t)cnt * PAGE_SIZE, MADV_DONTNEED);
+}
+
+void Core::OS::CommitVirtualPages(int chain, int page, int cnt) {
+  //nothing needed for Linux - pages are committed on first touch
+}
+
+void Core::OS::FutexWait(int* addr, int value) {
+  syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, value, nullptr, nullptr, 0);
+}
+
+void Core::OS::FutexWake(int* addr, int count) {
+  syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
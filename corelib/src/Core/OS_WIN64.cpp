@@ -17,62 +17,103 @@ union uptr {
 #undef int64
 #define int64 long long
 
+#pragma comment(lib, "Synchronization.lib")  //WaitOnAddress()
+
 void Core::OS::ThreadGetHandle(System::Thread* thread) {
   //NOTE : GetCurrentThread() returns a pseudo thread that is ALWAYS the current thread
   //Must call OpenThread() or DuplicateThread()
   thread->NativeHandle = OpenThread(READ_CONTROL | THREAD_GET_CONTEXT, false, GetCurrentThreadId());
 }
 
-int Core::OS::GetThreadContextCount() {
+int Core::OS::GetRegisterCount() {
   return 16;  //RAX thru R15
 }
 
 // see https://docs.microsoft.com/en-us/windows/win32/api/winnt/ns-winnt-context
-static CONTEXT thread_context;
+void Core::OS::SaveRegisters(void** regs) {
+  CONTEXT context;
+  RtlCaptureContext(&context);
+  std::memcpy((void*)regs, &context.Rax, 16 * sizeof(void*));  //RAX thru R15
+}
 
-void Core::OS::GetThreadContext(System::Thread *thread, void** context) {
-  thread_context.ContextFlags = CONTEXT_CONTROL | CONTEXT_INTEGER;
-  HANDLE handle = (HANDLE)thread->NativeHandle;
-  if (!::GetThreadContext(handle, &thread_context)) {
-    printf("Error:GetThreadContext() failed : %x\n", GetLastError());
+void Core::OS::ThreadInit(System::Thread *thread) {
+  //nothing needed for Win64
+}
+
+//each chain reserves its whole address range once (VirtualAlloc reservations are 64KB aligned and can only be released whole)
+//pages are then committed and decommitted in place, the GC tracks which pages are in use
+#define CHAIN_PAGES 0x100000
+static bool chain_reserved[256];
+
+static void ReserveChain(int chain) {
+  if (chain_reserved[chain]) return;
+  uptr ptr;
+  ptr.vptr = nullptr;
+  ptr.v64 = chain;
+  ptr.v64 <<= 40;
+  if (VirtualAlloc(ptr.vptr, (size_t)CHAIN_PAGES * PAGE_SIZE, MEM_RESERVE, PAGE_READWRITE) == nullptr) {
+    printf("Error:Unable to reserve memory pages for chain %d\n", chain);
     std::exit(1);
   }
-  std::memcpy((void*)context, &thread_context.Rax, 16 * sizeof(void*));  //RAX thru R15
-  uptr rsp;
-  rsp.v64 = (int64)thread_context.Rsp;
-  thread->StackCurrent = rsp.vptr;
+  chain_reserved[chain] = true;
 }
 
-void Core::OS::ThreadInit(System::Thread *thread) {
-  //nothing needed for Win64
+int Core::OS::AllocateVirtualPages(int chain, int page, int cnt) {
+  ReserveChain(chain);
+  if (page + cnt > CHAIN_PAGES) {
+    printf("Error:No more memory pages available for chain %d\n", chain);
+    std::exit(1);
+  }
+  uptr ptr;
+  ptr.vptr = nullptr;
+  ptr.v64 = chain;
+  ptr.v64 <<= 40;
+  ptr.v64 += ((int64)page << 12);
+  if (VirtualAlloc(ptr.vptr, (size_t)cnt * PAGE_SIZE, MEM_COMMIT, PAGE_READWRITE) == nullptr) {
+    printf("Error:Unable to commit memory pages for chain %d\n", chain);
+    std::exit(1);
+  }
+  return page;
 }
 
-void Core::OS::ThreadSuspend(System::Thread *thread) {
-  HANDLE handle = (HANDLE)thread->NativeHandle;
-  SuspendThread(handle);
+void Core::OS::FreeVirtualPages(int chain, int page, int cnt) {
+  //pages are a sub-range of the chain reservation : decommit only (MEM_RELEASE needs the whole reservation)
+  uptr ptr;
+  ptr.vptr = nullptr;
+  ptr.v64 = chain;
+  ptr.v64 <<= 40;
+  ptr.v64 += ((int64)page << 12);
+  VirtualFree(ptr.vptr, (size_t)cnt * PAGE_SIZE, MEM_DECOMMIT);
 }
 
-void Core::OS::ThreadResume(System::Thread *thread) {
-  HANDLE handle = (HANDLE)thread->NativeHandle;
-  ResumeThread(handle);
+void Core::OS::DecommitVirtualPages(int chain, int page, int cnt) {
+  uptr ptr;
+  ptr.vptr = nullptr;
+  ptr.v64 = chain;
+  ptr.v64 <<= 40;
+  ptr.v64 += ((int64)page << 12);
+  VirtualFree(ptr.vptr, (size_t)cnt * PAGE_SIZE, MEM_DECOMMIT);
 }
 
-int Core::OS::AllocateVirtualPages(int chain, int page, int cnt) {
+void Core::OS::CommitVirtualPages(int chain, int page, int cnt) {
   uptr ptr;
   ptr.vptr = nullptr;
   ptr.v64 = chain;
   ptr.v64 <<= 40;
-  ptr.v64 += (page << 12);
-  do {
-    void* vptr = VirtualAlloc(ptr.vptr, cnt * PAGE_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-    if (vptr != nullptr) return page;
-    ptr.v64 += PAGE_SIZE;
-    page++;
-    if (page == 0x100000) {
-      printf("Error:No more memory pages available for chain %d\n", chain);
-      std:exit(1);
-    }
-  } while (true);
+  ptr.v64 += ((int64)page << 12);
+  VirtualAlloc(ptr.vptr, (size_t)cnt * PAGE_SIZE, MEM_COMMIT, PAGE_READWRITE);
+}
+
+void Core::OS::FutexWait(int* addr, int value) {
+  WaitOnAddress((volatile VOID*)addr, &value, sizeof(int), INFINITE);
+}
+
+void Core::OS::FutexWake(int* addr, int count) {
+  if (count == 1) {
+    WakeByAddressSingle((PVOID)addr);
+  } else {
+    WakeByAddressAll((PVOID)addr);
+  }
 }
 
 static DWORD input_console_mode;
@@ -5,11 +5,17 @@
 #include "Core\OS.cpp"
 #include "System\DateTime.cpp"
 #include "System\Exception.cpp"
+#include "System\HashGroup.cpp"
 #include "System\Mutex.cpp"
 #include "System\Object.cpp"
 #include "System\String.cpp"
 #include "System\Thread.cpp"
 #include "System\ValueType.cpp"
+#include "System\Collections\BoundedQueue.cpp"
+#include "System\Collections\ConcurrentQueue.cpp"
 #include "System\IO\File.cpp"
 #include "System\IO\InputStream.cpp"
 #include "System\IO\OutputStream.cpp"
+#include "System\Threading\Task.cpp"
+#include "System\Threading\ThreadPool.cpp"
+#include "System\Threading\WorkQueue.cpp"
@@ -9,6 +9,9 @@ namespace System {
     public int Length {
       get;
     }
+    /** Copies length elements (clamped to both arrays), src and dst may overlap.
+     * The compiler replaces every call with Core::$arraycopy (memmove), this body is the reference.
+     */
     public static void Copy<T>(T[] src, int srcOff, T[] dst, int dstOff, int length) {
       if (src == null) return;
       if (dst == null) return;
@@ -28,38 +31,148 @@ namespace System {
         dst[dstOff + off] = src[srcOff + off];
       }
     }
+
+    /** Sorts length elements starting at index (introsort : quicksort with a median of three pivot,
+     * heapsort when the recursion gets too deep, insertion sort for small ranges). Not stable.
+     */
+    public static void Sort<T>(T[] items, int index, int length, IComparer<T> comparer) {
+      if (length < 2) return;
+      int depth = 0;
+      for(int n=length;n>1;n>>=1) {
+        depth += 2;
+      }
+      IntroSort<T>(items, index, index + length - 1, depth, comparer);
+    }
+
+    /** Searches a sorted range, returns the index of value or the bitwise complement of where it would be inserted. */
+    public static int BinarySearch<T>(T[] items, int index, int length, T value, IComparer<T> comparer) {
+      int lo = index;
+      int hi = index + length - 1;
+      while (lo <= hi) {
+        int mid = lo + ((hi - lo) >> 1);
+        int c = comparer.Compare(items[mid], value);
+        if (c == 0) return mid;
+        if (c < 0) {
+          lo = mid + 1;
+        } else {
+          hi = mid - 1;
+        }
+      }
+      return ~lo;
+    }
+
+    private static void IntroSort<T>(T[] items, int lo, int hi, int depth, IComparer<T> comparer) {
+      while (hi - lo >= 16) {
+        if (depth == 0) {
+          HeapSort<T>(items, lo, hi, comparer);
+          return;
+        }
+        depth--;
+        int p = Partition<T>(items, lo, hi, comparer);
+        //recurse into the smaller side and loop on the larger one (stack depth is O(log n))
+        if (p - lo < hi - p) {
+          IntroSort<T>(items, lo, p - 1, depth, comparer);
+          lo = p + 1;
+        } else {
+          IntroSort<T>(items, p + 1, hi, depth, comparer);
+          hi = p - 1;
+        }
+      }
+      InsertionSort<T>(items, lo, hi, comparer);
+    }
+
+    private static void Swap<T>(T[] items, int a, int b) {
+      T t = items[a];
+      items[a] = items[b];
+      items[b] = t;
+    }
+
+    private static void SwapIfGreater<T>(T[] items, int a, int b, IComparer<T> comparer) {
+      if (comparer.Compare(items[a], items[b]) > 0) Swap<T>(items, a, b);
+    }
+
+    //median of three : items[lo] <= pivot <= items[hi] stop both scans without bounds checks
+    private static int Partition<T>(T[] items, int lo, int hi, IComparer<T> comparer) {
+      int mid = lo + ((hi - lo) >> 1);
+      SwapIfGreater<T>(items, lo, mid, comparer);
+      SwapIfGreater<T>(items, lo, hi, comparer);
+      SwapIfGreater<T>(items, mid, hi, comparer);
+      T pivot = items[mid];
+      Swap<T>(items, mid, hi - 1);
+      int left = lo;
+      int right = hi - 1;
+      while (left < right) {
+        left++;
+        while (comparer.Compare(items[left], pivot) < 0) left++;
+        right--;
+        while (comparer.Compare(pivot, items[right]) < 0) right--;
+        if (left >= right) break;
+        Swap<T>(items, left, right);
+      }
+      if (left != hi - 1) Swap<T>(items, left, hi - 1);
+      return left;
+    }
+
+    private static void InsertionSort<T>(T[] items, int lo, int hi, IComparer<T> comparer) {
+      for(int i=lo+1;i<=hi;i++) {
+        T t = items[i];
+        int j = i - 1;
+        while (j >= lo && comparer.Compare(t, items[j]) < 0) {
+          items[j + 1] = items[j];
+          j--;
+        }
+        items[j + 1] = t;
+      }
+    }
+
+    private static void HeapSort<T>(T[] items, int lo, int hi, IComparer<T> comparer) {
+      int n = hi - lo + 1;
+      for(int i=n>>1;i>=1;i--) {
+        DownHeap<T>(items, i, n, lo, comparer);
+      }
+      for(int i=n;i>1;i--) {
+        Swap<T>(items, lo, lo + i - 1);
+        DownHeap<T>(items, 1, i - 1, lo, comparer);
+      }
+    }
+
+    //heap nodes are 1 based : node i is items[lo + i - 1]
+    private static void DownHeap<T>(T[] items, int i, int n, int lo, IComparer<T> comparer) {
+      T d = items[lo + i - 1];
+      while (i <= (n >> 1)) {
+        int child = 2 * i;
+        if (child < n && comparer.Compare(items[lo + child - 1], items[lo + child]) < 0) child++;
+        if (comparer.Compare(d, items[lo + child - 1]) >= 0) break;
+        items[lo + i - 1] = items[lo + child - 1];
+        i = child;
+      }
+      items[lo + i - 1] = d;
+    }
   }
 
   /** Resizeable Array storage.
+  * Capacity doubles when full so Add() is amortized O(1).
   * Fast to add, slow to remove.
+  * foreach over an Array<T> is compiled to an indexed loop (GetEnumerator() is not called).
   */
   public class Array<T> where T : class {
     private T[] Elements;
-    private readonly int BlockSize = 1024;
-    private int Blocks;
     private int Length;
+    private static int MinCapacity = 16;
     public Array() {
-      Elements = new T[BlockSize];
-      Blocks = 1;
+      Elements = new T[MinCapacity];
       Length = 0;
     }
+    /** Creates an empty array with room for size elements. */
     public Array(int size) {
-      Blocks = size / BlockSize;
-      if (size % BlockSize != 0) {
-        Blocks++;
-      }
-      Elements = new T[Blocks * BlockSize];
+      if (size < 0) size = 0;
+      Elements = new T[size];
     }
+    /** BlockElements is the old growth block size : it is now only a minimum capacity. */
     public Array(int size, int BlockElements) {
-      BlockSize = 64;
-      while (BlockSize < BlockElements) {
-        BlockSize <<= 1;
-      }
-      Blocks = size / BlockSize;
-      if (size % BlockSize != 0) {
-        Blocks++;
-      }
-      Elements = new T[Blocks * BlockSize];
+      if (size < BlockElements) size = BlockElements;
+      if (size < 0) size = 0;
+      Elements = new T[size];
     }
     public T Get(int idx) {
       return Elements[idx];
@@ -70,16 +183,19 @@ namespace System {
     public int Size() {
       return Length;
     }
+    public int Capacity() {
+      return Elements.Length;
+    }
     public void Add(T value) {
       if (Elements.Length == Length) {
-        Grow(1);
+        Grow(Length + 1);
       }
       Elements[Length] = value;
       Length++;
     }
     public void Insert(int idx, T value) {
       if (Elements.Length == Length) {
-        Grow(1);
+        Grow(Length + 1);
       }
       if (idx < Length) {
         Array.Copy<T>(Elements, idx, Elements, idx+1, Length - idx);
@@ -105,7 +221,25 @@ namespace System {
         Array.Copy<T>(Elements, idx+1, Elements, idx, Length - idx - 1);
       }
       Length--;
-      //TODO : Shrink() ???
+      Elements[Length] = null;  //do not keep the element alive
+    }
+    public void Clear() {
+      for(int i=0;i<Length;i++) {
+        Elements[i] = null;
+      }
+      Length = 0;
+    }
+    /** Makes room for at least capacity elements (with one allocation). */
+    public void Reserve(int capacity) {
+      if (capacity > Elements.Length) {
+        Resize(capacity);
+      }
+    }
+    /** Releases unused capacity. */
+    public void TrimExcess() {
+      if (Length < Elements.Length) {
+        Resize(Length);
+      }
     }
     public T[] ToArray() {
       T[] copy = new T[Length];
@@ -116,9 +250,15 @@ namespace System {
       return new ArrayEnumerator<T>(this);
     }
 
-    private void Grow(int AddBlocks) {
-      Blocks += AddBlocks;
-      T[] NewElements = new T[Blocks * BlockSize];
+    private void Grow(int needed) {
+      int capacity = Elements.Length * 2;
+      if (capacity < MinCapacity) capacity = MinCapacity;
+      if (capacity < needed) capacity = needed;
+      Resize(capacity);
+    }
+
+    private void Resize(int capacity) {
+      T[] NewElements = new T[capacity];
       Array.Copy<T>(Elements, 0, NewElements, 0, Length);
       Elements = NewElements;
     }
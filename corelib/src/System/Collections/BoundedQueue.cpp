@@ -0,0 +1,73 @@
+#include <atomic>
+
+/** Bounded MPMC ring by Dmitry Vyukov : slot sequence == pos means free for the producer at pos,
+ * sequence == pos + 1 means full for the consumer at pos.
+ * head and tail are on separate cache lines (producers only write tail, consumers only write head).
+ * Items stay in a GC array so the collector sees them, dequeued slots are cleared.
+ */
+struct RingQueueIndex {
+  alignas(64) std::atomic<int64> head;
+  alignas(64) std::atomic<int64> tail;
+};
+
+void System::Collections::RingQueue::Create() {
+  RingQueueIndex *index = new RingQueueIndex();
+  index->head = 0;
+  index->tail = 0;
+  NativeIndex = (void*)index;
+}
+
+void System::Collections::RingQueue::Destroy() {
+  delete (RingQueueIndex*)NativeIndex;
+}
+
+bool System::Collections::RingQueue::TryEnqueue(System::Object *item) {
+  RingQueueIndex *index = (RingQueueIndex*)NativeIndex;
+  int64 mask = Items->Length - 1;
+  int64 pos = index->tail.load(std::memory_order_relaxed);
+  int64 cell;
+  while (true) {
+    cell = pos & mask;
+    int64 seq = Core::$atomic(&Sequence->Array[cell])->load(std::memory_order_acquire);
+    int64 dif = seq - pos;
+    if (dif == 0) {
+      if (index->tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+    } else if (dif < 0) {
+      return false;
+    } else {
+      pos = index->tail.load(std::memory_order_relaxed);
+    }
+  }
+  Core::$wb(&Items->Array[cell], item);
+  Core::$atomic(&Sequence->Array[cell])->store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+System::Object* System::Collections::RingQueue::TryDequeue() {
+  RingQueueIndex *index = (RingQueueIndex*)NativeIndex;
+  int64 mask = Items->Length - 1;
+  int64 pos = index->head.load(std::memory_order_relaxed);
+  int64 cell;
+  while (true) {
+    cell = pos & mask;
+    int64 seq = Core::$atomic(&Sequence->Array[cell])->load(std::memory_order_acquire);
+    int64 dif = seq - (pos + 1);
+    if (dif == 0) {
+      if (index->head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+    } else if (dif < 0) {
+      return nullptr;
+    } else {
+      pos = index->head.load(std::memory_order_relaxed);
+    }
+  }
+  System::Object *item = Items->Array[cell];
+  Items->Array[cell] = nullptr;
+  Core::$atomic(&Sequence->Array[cell])->store(pos + mask + 1, std::memory_order_release);
+  return item;
+}
+
+int System::Collections::RingQueue::Count() {
+  RingQueueIndex *index = (RingQueueIndex*)NativeIndex;
+  int64 count = index->tail.load(std::memory_order_relaxed) - index->head.load(std::memory_order_relaxed);
+  return count < 0 ? 0 : (int)count;
+}
@@ -0,0 +1,54 @@
+using System;
+
+namespace System.Collections {
+  /** Bounded multi-producer multi-consumer queue of Objects (Vyukov ring, see BoundedQueue.cpp).
+   * Each slot has a sequence number that tells producers and consumers whose turn it is, so there is no lock.
+   */
+  public class RingQueue {
+    public RingQueue(int capacity) {
+      int size = 2;
+      while (size < capacity) size <<= 1;
+      Items = new Object[size];
+      Sequence = new long[size];
+      for(int a=0;a<size;a++) {
+        Sequence[a] = a;
+      }
+      Create();
+    }
+    ~RingQueue() {
+      Destroy();
+    }
+    public extern bool TryEnqueue(Object item);  //returns false when full
+    public extern Object TryDequeue();  //returns null when empty
+    public extern int Count();  //approximate
+    public int Capacity() {
+      return Items.Length;
+    }
+
+    private Object[] Items;
+    private long[] Sequence;
+    private unsafe void* NativeIndex;  //head / tail
+    private extern void Create();
+    private extern void Destroy();
+  }
+
+  /** Bounded lock free queue (capacity is rounded up to a power of 2). */
+  public class BoundedQueue<T> where T : class {
+    private RingQueue ring;
+    public BoundedQueue(int capacity) {
+      ring = new RingQueue(capacity);
+    }
+    public bool TryEnqueue(T item) {
+      return ring.TryEnqueue(item);
+    }
+    public T TryDequeue() {
+      return (T)ring.TryDequeue();
+    }
+    public int Count() {
+      return ring.Count();
+    }
+    public int Capacity() {
+      return ring.Capacity();
+    }
+  }
+}
@@ -0,0 +1,190 @@
+using System;
+
+namespace System.Collections {
+  /** Thread safe hash map split into stripes : each stripe is a chained hash table with its own Mutex,
+   * so threads only contend when their keys hash to the same stripe.
+   * Keys use GetHashCode() / Equals().
+   */
+  public class ConcurrentDictionary<K, V> where K : class where V : class {
+    public class Entry<EK, EV> {
+      public EK Key;
+      public EV Value;
+      public int Hash;
+      public Entry<EK, EV> Next;
+    }
+    public class Stripe<SK, SV> {
+      public Mutex Lock = new Mutex();
+      public Entry<SK, SV>[] Buckets = new Entry<SK, SV>[16];
+      public int Count;
+    }
+    private Stripe<K, V>[] stripes;
+    private int mask;
+
+    /** Creates a map with at least concurrency stripes (0 = 4 per processor). */
+    public ConcurrentDictionary(int concurrency = 0) {
+      if (concurrency <= 0) concurrency = System.Threading.ThreadPool.GetProcessorCount() * 4;
+      int count = 1;
+      while (count < concurrency) count <<= 1;
+      stripes = new Stripe<K, V>[count];
+      for(int a=0;a<count;a++) {
+        stripes[a] = new Stripe<K, V>();
+      }
+      mask = count - 1;
+    }
+
+    private static int Spread(int hash) {
+      hash ^= (int)((uint)hash >> 16);
+      hash *= 0x45d9f3b;
+      hash ^= (int)((uint)hash >> 16);
+      return hash;
+    }
+
+    private Stripe<K, V> GetStripe(int hash) {
+      //stripe from a second multiply so it does not repeat the bucket bits
+      return stripes[(int)(((uint)hash * 0x9e3779b1) >> 16) & mask];
+    }
+
+    private static Entry<K, V> Find(Stripe<K, V> stripe, K key, int hash) {
+      Entry<K, V> entry = stripe.Buckets[hash & (stripe.Buckets.Length - 1)];
+      while (entry != null) {
+        if (entry.Hash == hash && key.Equals(entry.Key)) return entry;
+        entry = entry.Next;
+      }
+      return null;
+    }
+
+    private static void Insert(Stripe<K, V> stripe, K key, V value, int hash) {
+      if (stripe.Count >= stripe.Buckets.Length - (stripe.Buckets.Length >> 2)) Grow(stripe);
+      Entry<K, V> entry = new Entry<K, V>();
+      entry.Key = key;
+      entry.Value = value;
+      entry.Hash = hash;
+      int idx = hash & (stripe.Buckets.Length - 1);
+      entry.Next = stripe.Buckets[idx];
+      stripe.Buckets[idx] = entry;
+      stripe.Count++;
+    }
+
+    private static void Grow(Stripe<K, V> stripe) {
+      Entry<K, V>[] old = stripe.Buckets;
+      Entry<K, V>[] buckets = new Entry<K, V>[old.Length * 2];
+      int bmask = buckets.Length - 1;
+      for(int a=0;a<old.Length;a++) {
+        Entry<K, V> entry = old[a];
+        while (entry != null) {
+          Entry<K, V> next = entry.Next;
+          int idx = entry.Hash & bmask;
+          entry.Next = buckets[idx];
+          buckets[idx] = entry;
+          entry = next;
+        }
+      }
+      stripe.Buckets = buckets;
+    }
+
+    /** Returns the value of key or null. */
+    public V Get(K key) {
+      int hash = Spread(key.GetHashCode());
+      Stripe<K, V> stripe = GetStripe(hash);
+      stripe.Lock.Lock();
+      try {
+        Entry<K, V> entry = Find(stripe, key, hash);
+        return entry == null ? null : entry.Value;
+      } finally {
+        stripe.Lock.Unlock();
+      }
+    }
+
+    public bool ContainsKey(K key) {
+      return Get(key) != null;
+    }
+
+    /** Adds or replaces the value of key. */
+    public void Set(K key, V value) {
+      int hash = Spread(key.GetHashCode());
+      Stripe<K, V> stripe = GetStripe(hash);
+      stripe.Lock.Lock();
+      try {
+        Entry<K, V> entry = Find(stripe, key, hash);
+        if (entry != null) {
+          entry.Value = value;
+        } else {
+          Insert(stripe, key, value, hash);
+        }
+      } finally {
+        stripe.Lock.Unlock();
+      }
+    }
+
+    /** Adds key if it is not present and returns the value in the map. */
+    public V GetOrAdd(K key, V value) {
+      int hash = Spread(key.GetHashCode());
+      Stripe<K, V> stripe = GetStripe(hash);
+      stripe.Lock.Lock();
+      try {
+        Entry<K, V> entry = Find(stripe, key, hash);
+        if (entry != null) return entry.Value;
+        Insert(stripe, key, value, hash);
+        return value;
+      } finally {
+        stripe.Lock.Unlock();
+      }
+    }
+
+    /** Adds key if it is not present, returns false if it was. */
+    public bool TryAdd(K key, V value) {
+      int hash = Spread(key.GetHashCode());
+      Stripe<K, V> stripe = GetStripe(hash);
+      stripe.Lock.Lock();
+      try {
+        if (Find(stripe, key, hash) != null) return false;
+        Insert(stripe, key, value, hash);
+        return true;
+      } finally {
+        stripe.Lock.Unlock();
+      }
+    }
+
+    /** Removes key and returns its value (or null). */
+    public V Remove(K key) {
+      int hash = Spread(key.GetHashCode());
+      Stripe<K, V> stripe = GetStripe(hash);
+      stripe.Lock.Lock();
+      try {
+        int idx = hash & (stripe.Buckets.Length - 1);
+        Entry<K, V> prev = null;
+        Entry<K, V> entry = stripe.Buckets[idx];
+        while (entry != null) {
+          if (entry.Hash == hash && key.Equals(entry.Key)) {
+            if (prev == null) {
+              stripe.Buckets[idx] = entry.Next;
+            } else {
+              prev.Next = entry.Next;
+            }
+            stripe.Count--;
+            return entry.Value;
+          }
+          prev = entry;
+          entry = entry.Next;
+        }
+        return null;
+      } finally {
+        stripe.Lock.Unlock();
+      }
+    }
+
+    public int Count() {
+      int count = 0;
+      for(int a=0;a<stripes.Length;a++) {
+        Stripe<K, V> stripe = stripes[a];
+        stripe.Lock.Lock();
+        try {
+          count += stripe.Count;
+        } finally {
+          stripe.Lock.Unlock();
+        }
+      }
+      return count;
+    }
+  }
+}
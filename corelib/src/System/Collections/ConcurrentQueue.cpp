@@ -0,0 +1,85 @@
+#include <atomic>
+#include <thread>
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+/** Producers take a slot index with fetch_add on Enqueued (indexes past the end mean the segment is full and a new one is linked).
+ * Consumers take an index with a CAS on Dequeued and then wait for the producer that owns the slot to store the item
+ * (it has no safepoint or allocation in between so the wait is short unless it is preempted).
+ */
+
+static inline void queue_pause() {
+#if defined(__x86_64__) || defined(_M_X64)
+  _mm_pause();
+#elif defined(__aarch64__)
+  __asm__ volatile("yield");
+#endif
+}
+
+void System::Collections::SegmentQueue::Enqueue(System::Object *item) {
+  static System::String *msg;
+  if (item == nullptr) throw new System::Exception(Core::$literal(&msg, u"ConcurrentQueue:null item"));
+  while (true) {
+    System::Collections::QueueSegment *segment = Core::$atomic(&Tail)->load(std::memory_order_acquire);
+    int size = segment->Items->Length;
+    int32 idx = Core::$atomic(&segment->Enqueued)->fetch_add(1);
+    if (idx < size) {
+      System::Object **slot = &segment->Items->Array[idx];
+      Core::$atomic(slot)->store(item, std::memory_order_release);
+      if (Core::$gc_marking) Core::$gc_shade((void*)item);
+      if (Core::$gc_cards != nullptr) Core::$gc_card((void*)slot);
+      return;
+    }
+    //segment is full : link the next one (if no other producer did) and move the tail
+    System::Collections::QueueSegment *next = Core::$atomic(&segment->Next)->load(std::memory_order_acquire);
+    if (next == nullptr) {
+      System::Collections::QueueSegment *created = new System::Collections::QueueSegment();
+      if (Core::$cas(&segment->Next, (System::Collections::QueueSegment*)nullptr, created)) {
+        next = created;
+      } else {
+        next = Core::$atomic(&segment->Next)->load(std::memory_order_acquire);
+      }
+    }
+    Core::$cas(&Tail, segment, next);
+  }
+}
+
+System::Object* System::Collections::SegmentQueue::TryDequeue() {
+  while (true) {
+    System::Collections::QueueSegment *segment = Core::$atomic(&Head)->load(std::memory_order_acquire);
+    int size = segment->Items->Length;
+    int32 idx = Core::$atomic(&segment->Dequeued)->load(std::memory_order_acquire);
+    int32 end = Core::$atomic(&segment->Enqueued)->load(std::memory_order_acquire);
+    if (end > size) end = size;
+    if (idx < end) {
+      if (!Core::$atomic(&segment->Dequeued)->compare_exchange_weak(idx, idx + 1)) continue;
+      System::Object **slot = &segment->Items->Array[idx];
+      System::Object *item;
+      int spins = 0;
+      while ((item = Core::$atomic(slot)->load(std::memory_order_acquire)) == nullptr) {
+        if (++spins < 64) queue_pause(); else std::this_thread::yield();  //producer was preempted
+      }
+      *slot = nullptr;  //do not keep the item alive
+      return item;
+    }
+    if (idx < size) return nullptr;  //empty
+    //segment is consumed : move to the next one
+    System::Collections::QueueSegment *next = Core::$atomic(&segment->Next)->load(std::memory_order_acquire);
+    if (next == nullptr) return nullptr;
+    Core::$cas(&Head, segment, next);
+  }
+}
+
+bool System::Collections::SegmentQueue::IsEmpty() {
+  System::Collections::QueueSegment *segment = Core::$atomic(&Head)->load(std::memory_order_acquire);
+  while (segment != nullptr) {
+    int size = segment->Items->Length;
+    int32 end = Core::$atomic(&segment->Enqueued)->load(std::memory_order_acquire);
+    if (end > size) end = size;
+    if (Core::$atomic(&segment->Dequeued)->load(std::memory_order_acquire) < end) return false;
+    if (end < size) return true;
+    segment = Core::$atomic(&segment->Next)->load(std::memory_order_acquire);
+  }
+  return true;
+}
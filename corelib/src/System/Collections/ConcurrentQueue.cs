@@ -0,0 +1,44 @@
+using System;
+
+namespace System.Collections {
+  /** Fixed array of slots used once : producers claim slots with Enqueued, consumers with Dequeued (see ConcurrentQueue.cpp). */
+  public class QueueSegment {
+    public QueueSegment() {
+      Items = new Object[1024];
+    }
+    private Object[] Items;  //null until the producer stored the item
+    private int Enqueued;
+    private int Dequeued;
+    private QueueSegment Next;
+  }
+
+  /** Unbounded multi-producer multi-consumer queue of Objects : a linked list of QueueSegments.
+   * Segments are never reused so there is no ABA problem, the GC frees them once consumed.
+   */
+  public class SegmentQueue {
+    public SegmentQueue() {
+      Head = new QueueSegment();
+      Tail = Head;
+    }
+    public extern void Enqueue(Object item);
+    public extern Object TryDequeue();  //returns null when empty
+    public extern bool IsEmpty();
+
+    private QueueSegment Head;
+    private QueueSegment Tail;
+  }
+
+  /** Unbounded lock free FIFO queue (items must not be null). */
+  public class ConcurrentQueue<T> where T : class {
+    private SegmentQueue queue = new SegmentQueue();
+    public void Enqueue(T item) {
+      queue.Enqueue(item);
+    }
+    public T TryDequeue() {
+      return (T)queue.TryDequeue();
+    }
+    public bool IsEmpty() {
+      return queue.IsEmpty();
+    }
+  }
+}
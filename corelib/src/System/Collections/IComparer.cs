@@ -0,0 +1,20 @@
+using System;
+
+namespace System.Collections {
+  /** Orders two items : < 0 if x is before y, 0 if equal, > 0 if x is after y. */
+  public interface IComparer<T> {
+    int Compare(T x, T y);
+  }
+
+  /** Default comparer : items must implement IComparable. */
+  public class ComparableComparer<T> : IComparer<T> where T : class {
+    public int Compare(T x, T y) {
+      if (x == y) return 0;
+      if (x == null) return -1;
+      if (y == null) return 1;
+      IComparable cx = x as IComparable;
+      if (cx == null) throw new Exception("IComparer:item is not IComparable");
+      return cx.CompareTo(y);
+    }
+  }
+}
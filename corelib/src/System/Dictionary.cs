@@ -0,0 +1,204 @@
+using System.Collections;
+
+namespace System {
+  /** Hash map with open addressing in flat arrays (SwissTable layout, see HashGroup).
+   * A lookup compares 16 control bytes at once and only calls Equals() on slots with the same 7 hash bits.
+   * Keys use GetHashCode() / Equals().
+   * Enumerate without allocation with Next() / KeyAt() / ValueAt() :
+   *   for(int i=map.Next(-1);i!=-1;i=map.Next(i)) {...}
+   */
+  public class Dictionary<K, V> where K : class where V : class {
+    private byte[] ctrl;
+    private K[] keys;
+    private V[] values;
+    private int count;
+    private int used;  //full + deleted slots
+    private int groupMask;
+
+    public Dictionary(int capacity = 0) {
+      Init(capacity);
+    }
+
+    private void Init(int capacity) {
+      int slots = HashGroup.Size;
+      while (slots - (slots >> 3) < capacity) slots <<= 1;
+      ctrl = new byte[slots];
+      HashGroup.Reset(ctrl);
+      keys = new K[slots];
+      values = new V[slots];
+      groupMask = slots / HashGroup.Size - 1;
+      count = 0;
+      used = 0;
+    }
+
+    private int Find(K key, int hash) {
+      int h2 = hash & 0x7f;
+      int group = (int)((uint)hash >> 7) & groupMask;
+      int step = 0;
+      while (true) {
+        int pos = group * HashGroup.Size;
+        int bits = HashGroup.Match(ctrl, pos, h2);
+        int idx = pos;
+        while (bits != 0) {
+          if ((bits & 1) != 0 && key.Equals(keys[idx])) return idx;
+          bits >>= 1;
+          idx++;
+        }
+        if (HashGroup.HasEmpty(ctrl, pos)) return -1;
+        step++;
+        group = (group + step) & groupMask;  //triangular probing visits every group
+      }
+    }
+
+    //first EMPTY or DELETED slot for a key that is not in the table
+    private int FindFree(int hash) {
+      int group = (int)((uint)hash >> 7) & groupMask;
+      int step = 0;
+      while (true) {
+        int pos = group * HashGroup.Size;
+        int bits = HashGroup.MatchFree(ctrl, pos);
+        if (bits != 0) {
+          int idx = pos;
+          while ((bits & 1) == 0) {
+            bits >>= 1;
+            idx++;
+          }
+          return idx;
+        }
+        step++;
+        group = (group + step) & groupMask;
+      }
+    }
+
+    private void Insert(K key, V value, int hash) {
+      if (used >= keys.Length - (keys.Length >> 3)) {
+        Rehash();
+      }
+      int idx = FindFree(hash);
+      if (ctrl[idx] == HashGroup.Empty) used++;
+      ctrl[idx] = (byte)(hash & 0x7f);
+      keys[idx] = key;
+      values[idx] = value;
+      count++;
+    }
+
+    //sized for 1.5 x count : doubles when full of keys, stays (or shrinks) when most slots are DELETED
+    private void Rehash() {
+      byte[] oldCtrl = ctrl;
+      K[] oldKeys = keys;
+      V[] oldValues = values;
+      Init(count + (count >> 1) + 1);
+      for(int a=0;a<oldKeys.Length;a++) {
+        if ((oldCtrl[a] & 0x80) != 0) continue;
+        K key = oldKeys[a];
+        int hash = HashGroup.Spread(key.GetHashCode());
+        int idx = FindFree(hash);
+        ctrl[idx] = (byte)(hash & 0x7f);
+        keys[idx] = key;
+        values[idx] = oldValues[a];
+        used++;
+        count++;
+      }
+    }
+
+    /** Returns the value of key or null. */
+    public V Get(K key) {
+      int idx = Find(key, HashGroup.Spread(key.GetHashCode()));
+      if (idx == -1) return null;
+      return values[idx];
+    }
+
+    public bool ContainsKey(K key) {
+      return Find(key, HashGroup.Spread(key.GetHashCode())) != -1;
+    }
+
+    /** Adds or replaces the value of key. */
+    public void Set(K key, V value) {
+      int hash = HashGroup.Spread(key.GetHashCode());
+      int idx = Find(key, hash);
+      if (idx != -1) {
+        values[idx] = value;
+        return;
+      }
+      Insert(key, value, hash);
+    }
+
+    /** Adds key if it is not present, returns false if it was. */
+    public bool TryAdd(K key, V value) {
+      int hash = HashGroup.Spread(key.GetHashCode());
+      if (Find(key, hash) != -1) return false;
+      Insert(key, value, hash);
+      return true;
+    }
+
+    /** Removes key and returns its value (or null). */
+    public V Remove(K key) {
+      int idx = Find(key, HashGroup.Spread(key.GetHashCode()));
+      if (idx == -1) return null;
+      V value = values[idx];
+      keys[idx] = null;
+      values[idx] = null;
+      //a group with an EMPTY slot ends every probe that reaches it : the slot can be EMPTY again
+      if (HashGroup.HasEmpty(ctrl, idx & ~(HashGroup.Size - 1))) {
+        ctrl[idx] = HashGroup.Empty;
+        used--;
+      } else {
+        ctrl[idx] = HashGroup.Deleted;
+      }
+      count--;
+      return value;
+    }
+
+    public int Count() {
+      return count;
+    }
+
+    public void Clear() {
+      Init(0);
+    }
+
+    /** Next slot in use after index (-1 to start), returns -1 at the end. */
+    public int Next(int index) {
+      int length = keys.Length;
+      for(int a=index+1;a<length;a++) {
+        if ((ctrl[a] & 0x80) == 0) return a;
+      }
+      return -1;
+    }
+    public K KeyAt(int index) {
+      return keys[index];
+    }
+    public V ValueAt(int index) {
+      return values[index];
+    }
+
+    /** Enumerates the keys. */
+    public IEnumerator<K> GetEnumerator() {
+      return new DictionaryEnumerator<K, V>(this);
+    }
+  }
+
+  public class DictionaryEnumerator<K, V> : IEnumerator<K> where K : class where V : class {
+    public DictionaryEnumerator(Dictionary<K, V> map) {this.map = map;}
+    private readonly Dictionary<K, V> map;
+    private int idx = -1;  //-2 = done
+    public bool MoveNext() {
+      if (idx == -2) return false;
+      idx = map.Next(idx);
+      if (idx == -1) {
+        idx = -2;
+        return false;
+      }
+      return true;
+    }
+    public K Current {
+      get {
+        if (idx < 0) return default(K);
+        return map.KeyAt(idx);
+      }
+    }
+    public void Reset() {
+      idx = -1;
+    }
+  }
+}
@@ -1,5 +1,9 @@
 namespace System {
   public class Environment {
     public extern static void Collect();  //invoke Garbage Collector (see Object.cpp)
+    /** Sets max bytes of committed heap memory (0 = unlimited, default is CCSHARP_GC_MAX_HEAP).
+     * Allocations that do not fit after a full collection throw OutOfMemoryException. */
+    public extern static void SetMaxHeap(long bytes);
+    public extern static long GetMaxHeap();
   }
 }
@@ -0,0 +1,38 @@
+namespace System {
+  public class GC {
+    public static void Collect() {
+      Environment.Collect();
+    }
+    public extern static bool IsConcurrent();  //set CCSHARP_GC_CONCURRENT=1 to mark while threads run (see Object.cpp)
+    public extern static long CollectionCount();
+    //pause times are in microseconds (all threads stopped)
+    public extern static long GetLastPause();
+    public extern static long GetMaxPause();
+    public extern static long GetTotalPause();
+    public extern static long GetPauseCount();
+    public extern static void ResetPauses();
+    //pause histogram : bucket n counts pauses < 2^n microseconds (last bucket counts all longer pauses)
+    public extern static int GetPauseBucketCount();
+    public extern static long GetPauseHistogram(int bucket);
+    //last collection (set CCSHARP_GC_LOG=file to log every collection as a JSON line)
+    public extern static long MinorCollectionCount();
+    public extern static long GetLastCollectTime();  //microseconds (marking, minor collections include sweeping)
+    public extern static long GetLastSweepTime();  //microseconds spent sweeping after the previous collection
+    public extern static long GetLastFreedBytes();  //bytes freed after the previous collection
+    public extern static long GetLiveBytes();  //bytes live after the last collection
+    //allocation
+    public extern static long GetTotalAllocatedBytes();  //thread buffers are added when they are refilled
+    public extern static long GetAllocatedBytesForCurrentThread();
+    public extern static long GetAllocationCountForCurrentThread();  //objects allocated by this thread
+    //size classes (last class is the large object space)
+    public extern static int GetSizeClassCount();
+    public extern static int GetSizeClassSize(int cls);  //object size (0 = large objects)
+    public extern static long GetSizeClassHeap(int cls);
+    public extern static long GetSizeClassUsed(int cls);
+    //heap statistics (bytes)
+    public extern static long GetHeapSize();  //memory in blocks (small object blocks and large objects)
+    public extern static long GetHeapUsed();  //allocated objects (rounded up to their size class)
+    /** Returns per-mille of heap not holding requested object bytes (0 - 1000) : free slots plus size class rounding. */
+    public extern static long GetFragmentation();
+  }
+}
@@ -0,0 +1,50 @@
+#include <cstring>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define HASH_SSE2
+#endif
+
+void System::HashGroup::Reset(Core::FixedArray$T<uint8> *ctrl) {
+  std::memset(ctrl->Array, 0x80, ctrl->Length);
+}
+
+int32 System::HashGroup::Match(Core::FixedArray$T<uint8> *ctrl, int32 pos, int32 h2) {
+  const uint8 *group = ctrl->Array + pos;
+#ifdef HASH_SSE2
+  __m128i g = _mm_loadu_si128((const __m128i*)group);
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8((char)h2)));
+#else
+  int32 bits = 0;
+  for(int a=0;a<16;a++) {
+    if (group[a] == h2) bits |= 1 << a;
+  }
+  return bits;
+#endif
+}
+
+bool System::HashGroup::HasEmpty(Core::FixedArray$T<uint8> *ctrl, int32 pos) {
+  const uint8 *group = ctrl->Array + pos;
+#ifdef HASH_SSE2
+  __m128i g = _mm_loadu_si128((const __m128i*)group);
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8((char)0x80))) != 0;
+#else
+  for(int a=0;a<16;a++) {
+    if (group[a] == 0x80) return true;
+  }
+  return false;
+#endif
+}
+
+int32 System::HashGroup::MatchFree(Core::FixedArray$T<uint8> *ctrl, int32 pos) {
+  const uint8 *group = ctrl->Array + pos;
+#ifdef HASH_SSE2
+  //EMPTY and DELETED are the only control bytes with the high bit set
+  return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#else
+  int32 bits = 0;
+  for(int a=0;a<16;a++) {
+    if (group[a] & 0x80) bits |= 1 << a;
+  }
+  return bits;
+#endif
+}
@@ -0,0 +1,24 @@
+namespace System {
+  /** Control bytes of open addressing hash tables (Dictionary, HashSet) : SwissTable layout.
+   * Each slot has a control byte : EMPTY, DELETED or FULL (low 7 bits of the hash).
+   * Tables probe aligned groups of 16 slots, the group is compared at once (SSE2, see HashGroup.cpp).
+   */
+  public class HashGroup {
+    public static int Size = 16;
+    public static byte Empty = 0x80;
+    public static byte Deleted = 0xfe;
+
+    public extern static void Reset(byte[] ctrl);  //all slots EMPTY
+    public extern static int Match(byte[] ctrl, int pos, int h2);  //bits of slots == h2
+    public extern static bool HasEmpty(byte[] ctrl, int pos);  //probing stops at a group with an EMPTY slot
+    public extern static int MatchFree(byte[] ctrl, int pos);  //bits of EMPTY or DELETED slots
+
+    /** Mixes a GetHashCode() value : low 7 bits go to the control byte, the rest select the group. */
+    public static int Spread(int hash) {
+      hash ^= (int)((uint)hash >> 16);
+      hash *= 0x45d9f3b;
+      hash ^= (int)((uint)hash >> 16);
+      return hash;
+    }
+  }
+}
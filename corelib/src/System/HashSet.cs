@@ -0,0 +1,166 @@
+using System.Collections;
+
+namespace System {
+  /** Hash set with open addressing in flat arrays (same layout as Dictionary, see HashGroup).
+   * Enumerate without allocation with Next() / ItemAt() :
+   *   for(int i=set.Next(-1);i!=-1;i=set.Next(i)) {...}
+   */
+  public class HashSet<T> where T : class {
+    private byte[] ctrl;
+    private T[] items;
+    private int count;
+    private int used;  //full + deleted slots
+    private int groupMask;
+
+    public HashSet(int capacity = 0) {
+      Init(capacity);
+    }
+
+    private void Init(int capacity) {
+      int slots = HashGroup.Size;
+      while (slots - (slots >> 3) < capacity) slots <<= 1;
+      ctrl = new byte[slots];
+      HashGroup.Reset(ctrl);
+      items = new T[slots];
+      groupMask = slots / HashGroup.Size - 1;
+      count = 0;
+      used = 0;
+    }
+
+    private int Find(T item, int hash) {
+      int h2 = hash & 0x7f;
+      int group = (int)((uint)hash >> 7) & groupMask;
+      int step = 0;
+      while (true) {
+        int pos = group * HashGroup.Size;
+        int bits = HashGroup.Match(ctrl, pos, h2);
+        int idx = pos;
+        while (bits != 0) {
+          if ((bits & 1) != 0 && item.Equals(items[idx])) return idx;
+          bits >>= 1;
+          idx++;
+        }
+        if (HashGroup.HasEmpty(ctrl, pos)) return -1;
+        step++;
+        group = (group + step) & groupMask;
+      }
+    }
+
+    private int FindFree(int hash) {
+      int group = (int)((uint)hash >> 7) & groupMask;
+      int step = 0;
+      while (true) {
+        int pos = group * HashGroup.Size;
+        int bits = HashGroup.MatchFree(ctrl, pos);
+        if (bits != 0) {
+          int idx = pos;
+          while ((bits & 1) == 0) {
+            bits >>= 1;
+            idx++;
+          }
+          return idx;
+        }
+        step++;
+        group = (group + step) & groupMask;
+      }
+    }
+
+    private void Rehash() {
+      byte[] oldCtrl = ctrl;
+      T[] oldItems = items;
+      Init(count + (count >> 1) + 1);
+      for(int a=0;a<oldItems.Length;a++) {
+        if ((oldCtrl[a] & 0x80) != 0) continue;
+        T item = oldItems[a];
+        int hash = HashGroup.Spread(item.GetHashCode());
+        int idx = FindFree(hash);
+        ctrl[idx] = (byte)(hash & 0x7f);
+        items[idx] = item;
+        used++;
+        count++;
+      }
+    }
+
+    /** Adds item, returns false if it was already present. */
+    public bool Add(T item) {
+      int hash = HashGroup.Spread(item.GetHashCode());
+      if (Find(item, hash) != -1) return false;
+      if (used >= items.Length - (items.Length >> 3)) {
+        Rehash();
+      }
+      int idx = FindFree(hash);
+      if (ctrl[idx] == HashGroup.Empty) used++;
+      ctrl[idx] = (byte)(hash & 0x7f);
+      items[idx] = item;
+      count++;
+      return true;
+    }
+
+    public bool Contains(T item) {
+      return Find(item, HashGroup.Spread(item.GetHashCode())) != -1;
+    }
+
+    /** Removes item, returns false if it was not present. */
+    public bool Remove(T item) {
+      int idx = Find(item, HashGroup.Spread(item.GetHashCode()));
+      if (idx == -1) return false;
+      items[idx] = null;
+      if (HashGroup.HasEmpty(ctrl, idx & ~(HashGroup.Size - 1))) {
+        ctrl[idx] = HashGroup.Empty;
+        used--;
+      } else {
+        ctrl[idx] = HashGroup.Deleted;
+      }
+      count--;
+      return true;
+    }
+
+    public int Count() {
+      return count;
+    }
+
+    public void Clear() {
+      Init(0);
+    }
+
+    /** Next slot in use after index (-1 to start), returns -1 at the end. */
+    public int Next(int index) {
+      int length = items.Length;
+      for(int a=index+1;a<length;a++) {
+        if ((ctrl[a] & 0x80) == 0) return a;
+      }
+      return -1;
+    }
+    public T ItemAt(int index) {
+      return items[index];
+    }
+
+    public IEnumerator<T> GetEnumerator() {
+      return new HashSetEnumerator<T>(this);
+    }
+  }
+
+  public class HashSetEnumerator<T> : IEnumerator<T> where T : class {
+    public HashSetEnumerator(HashSet<T> set) {this.set = set;}
+    private readonly HashSet<T> set;
+    private int idx = -1;  //-2 = done
+    public bool MoveNext() {
+      if (idx == -2) return false;
+      idx = set.Next(idx);
+      if (idx == -1) {
+        idx = -2;
+        return false;
+      }
+      return true;
+    }
+    public T Current {
+      get {
+        if (idx < 0) return default(T);
+        return set.ItemAt(idx);
+      }
+    }
+    public void Reset() {
+      idx = -1;
+    }
+  }
+}
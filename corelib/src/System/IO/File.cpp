@@ -35,7 +35,7 @@ Core::FixedArray$T<System::IO::File*>* System::IO::File::List() {
   int length = list.size();
   Core::FixedArray$T<System::IO::File*>* filelist = new(length) Core::FixedArray$T<System::IO::File*>(&Core::Type_System_IO_File);
   for(int i=0;i<length;i++) {
-    filelist->at(i) = new System::IO::File((void*)(new QFileInfo(list.at(i))));
+    Core::$wb(&filelist->at(i), new System::IO::File((void*)(new QFileInfo(list.at(i)))));
   }
   return filelist;
 }
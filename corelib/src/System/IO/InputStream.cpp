@@ -19,12 +19,17 @@ void System::IO::InputStream::OpenString(System::String *filename) {
 
 int System::IO::InputStream::ReadByteArray(Core::FixedArray$T<uint8> *array) {
   QFile *file = (QFile*)Value;
+  Core::$GCNative native;
   return file->read((char*)array->Array, array->Length);
 }
 
 System::String* System::IO::InputStream::ReadString() {
   QFile *file = (QFile*)Value;
-  QByteArray ba = file->readLine();
+  QByteArray ba;
+  {
+    Core::$GCNative native;
+    ba = file->readLine();
+  }
   return Core::utf8ToString((const char*)ba.constData());
 }
 
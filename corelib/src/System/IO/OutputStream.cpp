@@ -18,5 +18,6 @@ void System::IO::OutputStream::OpenString(System::String *filename) {
 
 int System::IO::OutputStream::WriteByteArray(Core::FixedArray$T<uint8> *array) {
   QFile *file = (QFile*)Value;
+  Core::$GCNative native;  //may block on a full pipe or slow consumer
   return file->write((char*)array->Array, array->Length);
 }
@@ -0,0 +1,200 @@
+using System.Collections;
+
+namespace System {
+
+  public class LinkedListNode<T> where T : class {
+    public LinkedListNode<T> Prev;
+    public LinkedListNode<T> Next;
+    public T Value;
+  }
+
+  /** Doubly linked list of Objects.
+  * O(1) add and remove at both ends and of a known node, O(n) indexed access.
+  * Removed nodes are kept in a pool and reused by the next add, so a node must not be used after it was removed.
+  */
+  public class LinkedList<T> where T : class {
+    private LinkedListNode<T> Head, Tail;
+    private int Length;
+    private LinkedListNode<T> Free;  //pool of removed nodes (linked by Next)
+    private int FreeCount;
+    private static int MaxFree = 1024;
+
+    private LinkedListNode<T> NewNode(T Value) {
+      LinkedListNode<T> node = Free;
+      if (node != null) {
+        Free = node.Next;
+        FreeCount--;
+        node.Next = null;
+      } else {
+        node = new LinkedListNode<T>();
+      }
+      node.Value = Value;
+      return node;
+    }
+
+    private void FreeNode(LinkedListNode<T> node) {
+      node.Value = null;
+      node.Prev = null;
+      node.Next = null;
+      if (FreeCount == MaxFree) return;
+      node.Next = Free;
+      Free = node;
+      FreeCount++;
+    }
+
+    /** Fills the node pool so the next count adds do not allocate. */
+    public void Reserve(int count) {
+      if (count > MaxFree) count = MaxFree;
+      while (FreeCount < count) {
+        LinkedListNode<T> node = new LinkedListNode<T>();
+        node.Next = Free;
+        Free = node;
+        FreeCount++;
+      }
+    }
+
+    public LinkedListNode<T> Add(T Value) {
+      return AddLast(Value);
+    }
+    public LinkedListNode<T> AddLast(T Value) {
+      LinkedListNode<T> node = NewNode(Value);
+      if (Tail == null) {
+        Head = node;
+      } else {
+        node.Prev = Tail;
+        Tail.Next = node;
+      }
+      Tail = node;
+      Length++;
+      return node;
+    }
+    public LinkedListNode<T> AddFirst(T Value) {
+      LinkedListNode<T> node = NewNode(Value);
+      if (Head == null) {
+        Tail = node;
+      } else {
+        node.Next = Head;
+        Head.Prev = node;
+      }
+      Head = node;
+      Length++;
+      return node;
+    }
+    /** Inserts Value after node. */
+    public LinkedListNode<T> AddAfter(LinkedListNode<T> node, T Value) {
+      if (node == Tail) return AddLast(Value);
+      LinkedListNode<T> added = NewNode(Value);
+      added.Prev = node;
+      added.Next = node.Next;
+      node.Next.Prev = added;
+      node.Next = added;
+      Length++;
+      return added;
+    }
+    /** Removes the first node holding Value (same reference), returns false if not found. */
+    public bool Remove(T Value) {
+      LinkedListNode<T> node = Find(Value);
+      if (node == null) return false;
+      RemoveNode(node);
+      return true;
+    }
+    /** Removes node and returns it to the pool. */
+    public void RemoveNode(LinkedListNode<T> node) {
+      if (node.Prev != null) {
+        node.Prev.Next = node.Next;
+      } else {
+        Head = node.Next;
+      }
+      if (node.Next != null) {
+        node.Next.Prev = node.Prev;
+      } else {
+        Tail = node.Prev;
+      }
+      Length--;
+      FreeNode(node);
+    }
+    public T RemoveFirst() {
+      if (Head == null) return default(T);
+      T Value = Head.Value;
+      RemoveNode(Head);
+      return Value;
+    }
+    public T RemoveLast() {
+      if (Tail == null) return default(T);
+      T Value = Tail.Value;
+      RemoveNode(Tail);
+      return Value;
+    }
+    public LinkedListNode<T> Find(T Value) {
+      LinkedListNode<T> node = Head;
+      while (node != null) {
+        if (node.Value == Value) return node;
+        node = node.Next;
+      }
+      return null;
+    }
+    public void Clear() {
+      while (Head != null) {
+        RemoveNode(Head);
+      }
+    }
+    public int Size() {
+      return Length;
+    }
+    public T Get(int idx) {
+      LinkedListNode<T> node = Head;
+      while (idx > 0) {
+        if (node == null) return default(T);
+        node = node.Next;
+        idx--;
+      }
+      if (node == null) return default(T);
+      return node.Value;
+    }
+    public IEnumerator<T> GetEnumerator() {
+      return new LinkedListEnumerator<T>(this);
+    }
+    public LinkedListNode<T> GetHead() {
+      return Head;
+    }
+    public LinkedListNode<T> GetTail() {
+      return Tail;
+    }
+  }
+
+  public class LinkedListEnumerator<T> : IEnumerator<T> where T : class {
+    private LinkedListNode<T> node;
+    private LinkedList<T> list;
+    private bool started;
+    public LinkedListEnumerator(LinkedList<T> list) {
+      this.list = list;
+    }
+    public bool MoveNext() {
+      if (!started) {
+        started = true;
+        node = list.GetHead();
+      } else if (node != null) {
+        node = node.Next;
+      }
+      return node != null;
+    }
+    public bool MovePrev() {
+      if (node == null) return false;
+      node = node.Prev;
+      return node != null;
+    }
+    public bool HasValue() {
+      return node != null;
+    }
+    public void Reset() {
+      node = null;
+      started = false;
+    }
+    public T Current {
+      get {
+        if (node == null) return default(T);
+        return node.Value;
+      }
+    }
+  }
+}
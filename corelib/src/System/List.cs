@@ -2,113 +2,200 @@ using System.Collections;
 
 namespace System {
 
-  /** Linked-list of Objects.
-  * Slow to add, fast to remove.
+  /** Growable list of Objects stored in one contiguous array.
+  * O(1) indexed access, amortized O(1) Add() (capacity doubles), insert/remove in the middle move the tail (memmove).
+  * See LinkedList<T> for O(1) removal of known nodes.
+  * foreach over a List<T> is compiled to an indexed loop (GetEnumerator() is not called).
   */
-  public class List<T> where T : class{
-    public class Node<E> {
-      public Node<E> Prev;
-      public Node<E> Next;
-      public E Value;
-    }
-    private Node<T> Head, Tail;
+  public class List<T> where T : class {
+    private T[] Items;
     private int Length;
+    private static int MinCapacity = 16;
+    public List() {
+      Items = new T[MinCapacity];
+    }
+    /** Creates an empty list with room for capacity elements. */
+    public List(int capacity) {
+      if (capacity < 0) capacity = 0;
+      Items = new T[capacity];
+    }
     public void Add(T Value) {
-      Node<T> node = new Node<T>();
-      node.Value = Value;
-      if (Tail == null) {
-        Tail = node;
-        Head = node;
-      } else {
-        node.Prev = Tail;
-        Tail.Next = node;
-        Tail = node;
+      if (Length == Items.Length) Grow(Length + 1);
+      Items[Length] = Value;
+      Length++;
+    }
+    public void AddRange(List<T> list) {
+      InsertRange(Length, list);
+    }
+    public void Insert(int idx, T Value) {
+      if (idx < 0 || idx > Length) throw new ArrayBoundsException(idx, Length);
+      if (Length == Items.Length) Grow(Length + 1);
+      if (idx < Length) {
+        Array.Copy<T>(Items, idx, Items, idx + 1, Length - idx);
       }
+      Items[idx] = Value;
       Length++;
     }
-    public void Remove(T Value) {
-      Node<T> node = Head;
-      while (node != null) {
-        if (node.Value == Value) {
-          if (node.Prev != null) {
-            node.Prev.Next = node.Next;
-          }
-          if (node.Next != null) {
-            node.Next.Prev = node.Prev;
-          }
-          if (node == Head) {
-            Head = node.Next;
-          }
-          if (node == Tail) {
-            Tail = node.Prev;
-          }
-          Length--;
-          break;
-        }
-        node = node.Next;
+    public void InsertRange(int idx, List<T> list) {
+      if (idx < 0 || idx > Length) throw new ArrayBoundsException(idx, Length);
+      int cnt = list.Length;
+      if (cnt == 0) return;
+      if (Length + cnt > Items.Length) Grow(Length + cnt);
+      if (idx < Length) {
+        Array.Copy<T>(Items, idx, Items, idx + cnt, Length - idx);
+      }
+      if (list == this) {
+        //the source moved : copy the part before and after the gap
+        Array.Copy<T>(Items, 0, Items, idx, idx);
+        Array.Copy<T>(Items, idx + cnt, Items, idx + idx, cnt - idx);
+      } else {
+        Array.Copy<T>(list.Items, 0, Items, idx, cnt);
+      }
+      Length += cnt;
+    }
+    /** Removes the first element equal (same reference) to Value, returns false if not found. */
+    public bool Remove(T Value) {
+      int idx = IndexOf(Value);
+      if (idx == -1) return false;
+      RemoveAt(idx);
+      return true;
+    }
+    public void RemoveAt(int idx) {
+      RemoveRange(idx, 1);
+    }
+    public void RemoveRange(int idx, int cnt) {
+      if (idx < 0 || cnt < 0 || idx + cnt > Length) throw new ArrayBoundsException(idx + cnt, Length);
+      if (cnt == 0) return;
+      if (idx + cnt < Length) {
+        Array.Copy<T>(Items, idx + cnt, Items, idx, Length - idx - cnt);
+      }
+      int end = Length;
+      Length -= cnt;
+      for(int i=Length;i<end;i++) {
+        Items[i] = null;  //do not keep removed elements alive
       }
     }
+    /** Returns a new list with cnt elements starting at idx. */
+    public List<T> GetRange(int idx, int cnt) {
+      if (idx < 0 || cnt < 0 || idx + cnt > Length) throw new ArrayBoundsException(idx + cnt, Length);
+      List<T> range = new List<T>(cnt);
+      Array.Copy<T>(Items, idx, range.Items, 0, cnt);
+      range.Length = cnt;
+      return range;
+    }
+    public void Clear() {
+      for(int i=0;i<Length;i++) {
+        Items[i] = null;
+      }
+      Length = 0;
+    }
     public int Size() {
       return Length;
     }
+    public int Capacity() {
+      return Items.Length;
+    }
+    /** Makes room for at least capacity elements (with one allocation). */
+    public void Reserve(int capacity) {
+      if (capacity > Items.Length) Resize(capacity);
+    }
+    /** Releases unused capacity. */
+    public void TrimExcess() {
+      if (Length < Items.Length) Resize(Length);
+    }
     public T Get(int idx) {
-      Node<T> node = Head;
-      while (idx > 0) {
-        if (node == null) return default(T);
-        node = node.Next;
-        idx--;
+      if ((uint)idx >= (uint)Length) return default(T);
+      return Items[idx];
+    }
+    public void Set(int idx, T Value) {
+      if ((uint)idx >= (uint)Length) throw new ArrayBoundsException(idx, Length);
+      Items[idx] = Value;
+    }
+    public int IndexOf(T Value) {
+      for(int i=0;i<Length;i++) {
+        if (Items[i] == Value) return i;
       }
-      if (node == null) return default(T);
-      return node.Value;
+      return -1;
+    }
+    public bool Contains(T Value) {
+      return IndexOf(Value) != -1;
+    }
+    public void Reverse() {
+      int i = 0;
+      int j = Length - 1;
+      while (i < j) {
+        T t = Items[i];
+        Items[i] = Items[j];
+        Items[j] = t;
+        i++;
+        j--;
+      }
+    }
+    /** Sorts with IComparable.CompareTo(). */
+    public void Sort() {
+      Array.Sort<T>(Items, 0, Length, new ComparableComparer<T>());
+    }
+    /** Sorts with comparer (introsort, not stable). */
+    public void Sort(IComparer<T> comparer) {
+      Array.Sort<T>(Items, 0, Length, comparer);
+    }
+    public void Sort(int idx, int cnt, IComparer<T> comparer) {
+      if (idx < 0 || cnt < 0 || idx + cnt > Length) throw new ArrayBoundsException(idx + cnt, Length);
+      Array.Sort<T>(Items, idx, cnt, comparer);
+    }
+    /** Searches a sorted list, returns the index of Value or the bitwise complement of where it should be inserted. */
+    public int BinarySearch(T Value, IComparer<T> comparer) {
+      return Array.BinarySearch<T>(Items, 0, Length, Value, comparer);
+    }
+    public T[] ToArray() {
+      T[] copy = new T[Length];
+      Array.Copy<T>(Items, 0, copy, 0, Length);
+      return copy;
     }
     public IEnumerator<T> GetEnumerator() {
       return new ListEnumerator<T>(this);
     }
-    public Node<T> GetHead() {
-      return Head;
+
+    private void Grow(int needed) {
+      int capacity = Items.Length * 2;
+      if (capacity < MinCapacity) capacity = MinCapacity;
+      if (capacity < needed) capacity = needed;
+      Resize(capacity);
     }
-    public Node<T> GetTail() {
-      return Tail;
+
+    private void Resize(int capacity) {
+      T[] NewItems = new T[capacity];
+      Array.Copy<T>(Items, 0, NewItems, 0, Length);
+      Items = NewItems;
     }
   }
 
   public class ListEnumerator<T> : IEnumerator<T> where T : class {
-    private List<T>.Node<T> node;
     private List<T> list;
+    private int idx = -1;
     public ListEnumerator(List<T> list) {
       this.list = list;
     }
     public bool MoveNext() {
-      if (node == null) {
-        node = list.GetHead();
-        return true;
-      }
-      node = node.Next;
-      return node != null;
+      if (idx >= list.Size()) return false;
+      idx++;
+      return idx < list.Size();
     }
     public bool MovePrev() {
-      if (node == null) return false;
-      node = node.Prev;
-      return node != null;
+      if (idx < 0) return false;
+      idx--;
+      return idx >= 0;
     }
     public bool HasValue() {
-      return node != null;
+      return idx >= 0 && idx < list.Size();
     }
     public void Reset() {
-      node = null;
+      idx = -1;
     }
     public T Current {
       get {
-        if (node == null) return default(T);
-        return node.Value;
+        return list.Get(idx);
       }
     }
   }
-
-  public class ListTest {
-    public void Main(String[] args) {
-      List<Object> listObj = new List<Object>();
-      List<int> listInt = new List<int>();
-    }
-  }
 }
@@ -1,5 +1,11 @@
-#include <mutex>
-#include <condition_variable>
+#include <atomic>
+#include <climits>
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+//spins in Lock() before sleeping (most locks are held briefly)
+#define MUTEX_SPINS 100
 
 Core::Sync::Sync(System::Mutex *mutex) {
   mutex->Lock();
@@ -10,65 +16,98 @@ Core::Sync::~Sync() {
   mutex->Unlock();
 }
 
-void System::Mutex::Create() {
-  NativeMutex = (void*)new std::mutex();
-  NativeCondition = (void*)new std::condition_variable_any();
-  Owner = nullptr;
-  Count = 0;
+static inline void mutex_pause() {
+#if defined(__x86_64__) || defined(_M_X64)
+  _mm_pause();
+#elif defined(__aarch64__)
+  __asm__ volatile("yield");
+#endif
 }
 
-void System::Mutex::Destroy() {
-  std::mutex* mutex = (std::mutex*)NativeMutex;
-  std::condition_variable_any* condition = (std::condition_variable_any*)NativeCondition;
-  if (Count > 0) {
-    System::Console::WriteLine(Core::utf16ToString(u"Error:~Mutex while mutex is still locked"));
+/** Takes the lock word after a failed fast path (futex mutex, see "Futexes Are Tricky" by Drepper).
+ * Returns true if the thread had to sleep.
+ */
+static bool mutex_lock_slow(System::Mutex *mutex) {
+  std::atomic<int32> *state = Core::$atomic(&mutex->State);
+  for(int spin=0;spin<MUTEX_SPINS;spin++) {
+    int32 c = state->load(std::memory_order_relaxed);
+    if (c == 0 && state->compare_exchange_weak(c, 1, std::memory_order_acquire)) return false;
+    if (c == 2) break;  //others are already sleeping
+    mutex_pause();
+  }
+  if (state->exchange(2, std::memory_order_acquire) == 0) return false;
+  Core::$GCNative native;
+  do {
+    Core::OS::FutexWait(&mutex->State, 2);
+  } while (state->exchange(2, std::memory_order_acquire) != 0);
+  return true;
+}
+
+static inline void mutex_unlock(System::Mutex *mutex) {
+  if (Core::$atomic(&mutex->State)->exchange(0, std::memory_order_release) == 2) {
+    Core::OS::FutexWake(&mutex->State, 1);
   }
-  delete condition;
-  delete mutex;
 }
 
 void System::Mutex::Lock() {
-  std::mutex* mutex = (std::mutex*)NativeMutex;
-  if (Owner == System::Thread::Current()) {
-    Count++;
-  } else {
-    mutex->lock();
-    Count = 1;
-    Owner = System::Thread::Current();
+  System::Thread *self = System::Thread::Current();
+  int32 c = 0;
+  if (!Core::$atomic(&State)->compare_exchange_strong(c, 1, std::memory_order_acquire)) {
+    if (Owner == self) {
+      Count++;
+      return;
+    }
+    bool slept = mutex_lock_slow(this);
+    Contentions++;
+    if (slept) Sleeps++;
   }
+  Count = 1;
+  Owner = self;
 }
 
 void System::Mutex::Unlock() {
-  std::mutex* mutex = (std::mutex*)NativeMutex;
   if (Count == 0) {
-    System::Console::WriteLine(Core::utf16ToString(u"Error:Mutex unlock() but not locked"));
+    static System::String *msg;
+    System::Console::WriteLine(Core::$literal(&msg, u"Error:Mutex unlock() but not locked"));
     return;
   }
   Count--;
   if (Count == 0) {
     Owner = nullptr;
-    mutex->unlock();
+    mutex_unlock(this);
   }
 }
 
 void System::Mutex::Wait() {
-  std::mutex* mutex = (std::mutex*)NativeMutex;
-  std::condition_variable_any* condition = (std::condition_variable_any*)NativeCondition;
+  std::atomic<int32> *state = Core::$atomic(&State);
   int wcount = Count;
   System::Thread* wthread = Owner;
+  int32 seq = Core::$atomic(&Sequence)->load(std::memory_order_relaxed);
+  Core::$atomic(&Waiters)->fetch_add(1);
   Count = 0;
   Owner = nullptr;
-  condition->wait(*mutex);
+  mutex_unlock(this);
+  {
+    Core::$GCNative native;
+    Core::OS::FutexWait(&Sequence, seq);  //returns at once if notified since seq was read
+    //relock as contended : other waiters may have been woken too
+    while (state->exchange(2, std::memory_order_acquire) != 0) {
+      Core::OS::FutexWait(&State, 2);
+    }
+  }
+  Core::$atomic(&Waiters)->fetch_sub(1);
   Count = wcount;
   Owner = wthread;
 }
 
 void System::Mutex::NotifyOne() {
-  std::condition_variable_any* condition = (std::condition_variable_any*)NativeCondition;
-  condition->notify_one();
+  Core::$atomic(&Sequence)->fetch_add(1);
+  if (Core::$atomic(&Waiters)->load() == 0) return;
+  Core::OS::FutexWake(&Sequence, 1);
 }
 
 void System::Mutex::NotifyAll() {
-  std::condition_variable_any* condition = (std::condition_variable_any*)NativeCondition;
-  condition->notify_all();
+  Core::$atomic(&Sequence)->fetch_add(1);
+  if (Core::$atomic(&Waiters)->load() == 0) return;
+  Core::OS::FutexWake(&Sequence, INT_MAX);
 }
@@ -1,22 +1,34 @@
 namespace System {
+  /** Recursive lock with a condition (Wait / Notify).
+   * The lock is one word (State) in the object : uncontended Lock() / Unlock() is one atomic operation,
+   * contended Lock() spins briefly and then sleeps on the word (see Mutex.cpp).
+   */
   public class Mutex {
-    public Mutex() {
-      Create();
-    }
-    ~Mutex() {
-      Destroy();
-    }
+    public Mutex() {}
     public extern void Lock();
-    private extern void Unlock();
+    public extern void Unlock();
     public extern void Wait();
     public extern void NotifyOne();
     public extern void NotifyAll();
 
-    private unsafe void* NativeMutex;
-    private unsafe void* NativeCondition;
-    private int Count;
+    //contention counters (updated while the lock is held)
+    public long GetContentionCount() {
+      return Contentions;  //Lock() calls that found the lock held by another thread
+    }
+    public long GetSleepCount() {
+      return Sleeps;  //Lock() calls that had to sleep after spinning
+    }
+    public void ResetCounters() {
+      Contentions = 0;
+      Sleeps = 0;
+    }
+
+    private int State;  //0 = unlocked, 1 = locked, 2 = locked and threads may be sleeping
+    private int Sequence;  //condition : bumped by Notify
+    private int Waiters;  //threads in Wait()
+    private int Count;  //recursion
     private Thread Owner;
-    private extern void Create();
-    private extern void Destroy();
+    private long Contentions;
+    private long Sleeps;
   }
 }
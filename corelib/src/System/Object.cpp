@@ -5,10 +5,23 @@
  * My first attempt was very slow until I read "Garbage Collection in an Uncooperative Environment" by Hans-Juergen Boehm
  * which gave me some great ideas.
  *
- * TODO : reorganize the chain sizes into smaller objects less than 4K and only one chain for large objects that are multiples of 4K pages.
+ * Small objects (up to 32K) are grouped into size classes, each class has its own chain of blocks.
+ * Large objects are page granular and each one has its own block in the large object chains, the pages are returned to the OS when freed.
+ * Small object blocks that stay free are decommitted by the scavenger thread.
  *
  */
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <typeinfo>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 union uptr {
   void *vptr;
   int64 *ptr64;
@@ -45,8 +58,13 @@ static GC_static_ref* GC_static_list = nullptr;
 #define GC_TRACE
 #endif
 
-static int gc_last = 1;
-static int gc_mark = 1;
+//current mark epoch : objects are allocated with the current epoch (only changes while threads are suspended)
+static volatile int gc_mark = 1;
+
+//special mark values (gc_mark cycles between 1 and 0x7fffffff)
+#define GC_FREE 0
+#define GC_RESERVED -1  //owned by a thread allocation buffer (not allocated yet)
+#define GC_FINALIZE -2  //dead object waiting in finalizer queue
 
 //GC requires 64bit pointers and use of virtual addresses
 #define CHAIN_MASK 0x0000ff0000000000
@@ -62,7 +80,7 @@ static void* make_ptr(int chain, int page) {
   ptr.vptr = nullptr;
   ptr.v64 = chain + 1;
   ptr.v64 <<= 40;
-  ptr.v64 += (page << 12);
+  ptr.v64 += ((int64)page << 12);
   return ptr.vptr;
 }
 
@@ -71,42 +89,245 @@ static void* make_ptr(int chain, int page, int offset) {
   ptr.vptr = nullptr;
   ptr.v64 = chain + 1;
   ptr.v64 <<= 40;
-  ptr.v64 += (page << 12);
+  ptr.v64 += ((int64)page << 12);
   ptr.v64 += offset;
   return ptr.vptr;
 }
 
-/** Block points to one 4K page of memory that contains objects of a fixed size (power of 2). */
+static inline int GC_ctz(uint64 bits) {
+#ifdef _MSC_VER
+  unsigned long idx;
+  _BitScanForward64(&idx, bits);
+  return (int)idx;
+#else
+  return __builtin_ctzll(bits);
+#endif
+}
+
+static inline int GC_log2(uint64 value) {
+#ifdef _MSC_VER
+  unsigned long idx;
+  _BitScanReverse64(&idx, value);
+  return (int)idx;
+#else
+  return 63 - __builtin_clzll(value);
+#endif
+}
+
+static inline int GC_popcnt(uint64 bits) {
+#ifdef _MSC_VER
+  return (int)__popcnt64(bits);
+#else
+  return __builtin_popcountll(bits);
+#endif
+}
+
+/** Block points to one or more 4K pages of memory that contain objects of a fixed size (size class). */
 struct Block {
   int size;  //size of each object
+  uint64 recip;  //(2^40 / size) + 1 : object index = (offset * recip) >> 40 (0 for large objects)
   int count;  //# of objects in block
   int count_free;  //# of objects free in block
   int count_ptrs;  //# of pointers per object (size / 8)
   int page_first;
   int page_last;
   Block* next;
+  Block* next_free;  //next block in chain with free slots (see free_chains)
+  bool in_free_list;
   int *marks;
+  uint64 *free_bits;  //1 bit per object : 1 = free
+  int words;  //# of words in free_bits
+  int word_hint;  //all words below this index are full
+  int chain;
+  int swept;  //sweep epoch when block was last swept (see GC_sweep_block)
+  uint64 *old_bits;  //1 bit per object : 1 = survived a collection (old generation)
+  Block* next_young;  //next block with young objects (see young_list)
+  bool in_young_list;
+  bool released;  //large object block without pages (see GC_large_release)
+  bool decommitted;  //pages returned to OS (see GC_scavenge)
+  int idle;  //# of scavenger passes block was completely free
 
   void init(int size, int count, int page_first, int page_last) {
     this->size = size;
+    this->recip = count == 1 ? 0 : ((1ULL << 40) / size) + 1;
     this->count = count;
     this->count_free = count;
     this->count_ptrs = size / 8;
     this->next = nullptr;
+    this->next_free = nullptr;
+    this->in_free_list = false;
     this->marks = new int[count];
     this->page_first = page_first;
     this->page_last = page_last;
     std::memset(marks, 0, sizeof(int) * count);
+    words = (count + 63) / 64;
+    free_bits = new uint64[words];
+    std::memset(free_bits, 0xff, sizeof(uint64) * words);
+    if (count % 64 != 0) {
+      free_bits[words - 1] = (1ULL << (count % 64)) - 1;
+    }
+    word_hint = 0;
+    swept = 0;
+    old_bits = new uint64[words];
+    std::memset(old_bits, 0, sizeof(uint64) * words);
+    next_young = nullptr;
+    in_young_list = false;
+    released = false;
+    decommitted = false;
+    idle = 0;
+  }
+
+  /** Returns index of object containing ptr or -1 if ptr is past the last object. */
+  int index(uptr ptr) {
+    uint64 offset = (uint64)((ptr.v64 & (PAGE_MASK | OBJ_MASK)) - ((int64)page_first << 12));
+    int idx = (int)((offset * recip) >> 40);
+    return idx < count ? idx : -1;
+  }
+
+  /** Returns index of a free object and marks it used, or -1 if block is full. */
+  int alloc() {
+    for(int w=word_hint;w<words;w++) {
+      uint64 bits = free_bits[w];
+      if (bits != 0) {
+        int idx = (w << 6) + GC_ctz(bits);
+        free_bits[w] = bits & (bits - 1);
+        word_hint = w;
+        count_free--;
+        idle = 0;
+        return idx;
+      }
+    }
+    word_hint = words;
+    return -1;
+  }
+
+  void free(int idx) {
+    int w = idx >> 6;
+    free_bits[w] |= 1ULL << (idx & 63);
+    old_bits[w] &= ~(1ULL << (idx & 63));
+    if (w < word_hint) word_hint = w;
+    count_free++;
+  }
+
+  bool is_old(int idx) {
+    return (old_bits[idx >> 6] >> (idx & 63)) & 1;
+  }
+
+  void set_old(int idx) {
+    old_bits[idx >> 6] |= 1ULL << (idx & 63);
+  }
+
+  /** Recount free objects from the bitmap. */
+  int recount() {
+    int cnt = 0;
+    for(int w=0;w<words;w++) {
+      cnt += GC_popcnt(free_bits[w]);
+    }
+    count_free = cnt;
+    return cnt;
   }
 };
 
-#define NUM_CHAINS 24
+/** Size classes : 16 byte steps up to 256 bytes then 4 classes per doubling up to 32K (44 small chains).
+ * Objects larger than 32K are rounded to pages and allocated in the large object chains (one block per object).
+ */
+#define SMALL_CHAINS 44
+#define SMALL_MAX (32 * 1024)
+#define LARGE_CHAIN SMALL_CHAINS  //first large object chain
+#define LARGE_CHAINS 16  //each chain can address 4GB
+#define NUM_CHAINS (SMALL_CHAINS + LARGE_CHAINS)
 #define MAX_SIZE (256 * 1024 * 1024)
+#define LARGE_MIN (64 * 1024 * 1024)  //large object bytes allocated before a collection is triggered
+
+static int class_size[SMALL_CHAINS];
+static int class_pages[SMALL_CHAINS];  //pages per block
+
+//returns size class (chain) for a small object
+static inline int GC_size_class(int size) {
+  if (size <= 256) {
+    return size <= 16 ? 0 : ((size + 15) >> 4) - 1;
+  }
+  int lg = GC_log2(size - 1);
+  return 16 + (lg - 8) * 4 + (((size - 1) >> (lg - 2)) & 3);
+}
+
+static void GC_init_classes() {
+  for(int chain=0;chain<SMALL_CHAINS;chain++) {
+    int size = chain < 16 ? (chain + 1) * 16 : (256 << ((chain - 16) / 4)) + (((chain - 16) % 4) + 1) * (64 << ((chain - 16) / 4));
+    class_size[chain] = size;
+    //at least 8 objects per block, pick page count with least waste
+    int min = (size * 8 + PAGE_SIZE - 1) / PAGE_SIZE;
+    int best = min;
+    int best_waste = (min * PAGE_SIZE) % size;
+    for(int pages=min+1;pages<=min*2;pages++) {
+      int waste = (pages * PAGE_SIZE) % size;
+      if ((int64)waste * best < (int64)best_waste * pages) {
+        best = pages;
+        best_waste = waste;
+      }
+    }
+    class_pages[chain] = best;
+  }
+}
 
 Block *block_chains[NUM_CHAINS];
-//32,64,128,256,512,1k,2k,4k  //small objects (single page)
-//8k,16k,32k,64k,128k,256k,512k,1M  //large objects (multiple pages)
-//2M,4M,8M,16M,32M,64M,128M,256M  //extra large objects (same as large)
+static Block *free_chains[NUM_CHAINS];  //blocks with free slots (per chain)
+static Block *idle_chains[SMALL_CHAINS];  //decommitted blocks (per chain)
+
+//page directory : chain -> page >> 10 -> page & 1023 -> Block (constant time pointer to block lookup)
+#define DIR_BITS 10
+#define DIR_SIZE (1 << DIR_BITS)
+#define DIR_MASK (DIR_SIZE - 1)
+#define DIR_TOP ((int)((PAGE_MASK >> 12) / DIR_SIZE) + 1)
+
+static Block **page_dir[NUM_CHAINS][DIR_TOP];
+
+//card table : 1 byte per page set by the write barrier when a reference is stored (same layout as page_dir)
+static uint8 *card_dir[NUM_CHAINS * DIR_TOP];
+
+namespace Core {
+  uint8** $gc_cards = nullptr;  //card table used by Core::$wb (nullptr = generational collection disabled)
+}
+
+static void GC_page_dir_add(int chain, Block *blk) {
+  for(int page=blk->page_first;page<=blk->page_last;page++) {
+    Block **leaf = page_dir[chain][page >> DIR_BITS];
+    if (leaf == nullptr) {
+      leaf = new Block*[DIR_SIZE];
+      std::memset(leaf, 0, sizeof(Block*) * DIR_SIZE);
+      uint8 *cards = new uint8[DIR_SIZE];
+      std::memset(cards, 0, DIR_SIZE);
+      card_dir[chain * DIR_TOP + (page >> DIR_BITS)] = cards;
+      page_dir[chain][page >> DIR_BITS] = leaf;
+    }
+    leaf[page & DIR_MASK] = blk;
+  }
+}
+
+static void GC_page_dir_remove(int chain, Block *blk) {
+  for(int page=blk->page_first;page<=blk->page_last;page++) {
+    page_dir[chain][page >> DIR_BITS][page & DIR_MASK] = nullptr;
+    card_dir[chain * DIR_TOP + (page >> DIR_BITS)][page & DIR_MASK] = 0;
+  }
+}
+
+static inline bool GC_card_dirty(int chain, int page) {
+  return card_dir[chain * DIR_TOP + (page >> DIR_BITS)][page & DIR_MASK] != 0;
+}
+
+static void GC_cards_clear() {
+  for(int a=0;a<NUM_CHAINS * DIR_TOP;a++) {
+    if (card_dir[a] != nullptr) {
+      std::memset(card_dir[a], 0, DIR_SIZE);
+    }
+  }
+}
+
+static inline Block* GC_page_dir_get(int chain, int page) {
+  Block **leaf = page_dir[chain][page >> DIR_BITS];
+  if (leaf == nullptr) return nullptr;
+  return leaf[page & DIR_MASK];
+}
 
 static System::Mutex *gc_lock;
 static System::Mutex *gc_lock2;
@@ -114,32 +335,166 @@ static System::Thread *gc_thread = nullptr;
 static System::Thread *main_thread = nullptr;
 
 static void GC_reclaim_locked();
+static void GC_large_release(Block *blk);
+static void GC_shade_add(void** ptrs, int count);
+static void GC_sweep_block(int chain, Block *blk);
+static bool GC_sweep_next(int chain);
+static void GC_sweep_finish();
+
+/** Safepoints : threads stop themselves when they poll Core::$gc_safepoint (generated at method entry and loop back-edges).
+ * Threads blocked in native code (Mutex::Wait, I/O, etc.) are already stopped (see Core::$GCNative).
+ * The collector waits until every thread acknowledges (state != GC_RUNNING) before scanning roots.
+ */
+#define GC_RUNNING 0
+#define GC_NATIVE 1  //blocked in native code : registers and stack saved
+#define GC_STOPPED 2  //parked at a safepoint
+
+#define SHADE_BATCH 256
+
+struct GC_thread_state {
+  std::atomic<int> state;
+  void** regs;  //callee saved registers (see Core::OS::SaveRegisters)
+  int shade_count;  //references stored while marking, moved to shade_list when full or by the collector while stopped
+  void* shade[SHADE_BATCH];
+};
+
+namespace Core {
+  volatile bool $gc_safepoint = false;  //threads must stop
+}
 
-static uptr *gc_context;
-static int gc_context_count;
+static thread_local GC_thread_state *gc_state = nullptr;  //nullptr = not stopped by the collector (gc thread)
+static std::mutex safepoint_mutex;
+static std::condition_variable safepoint_cond;
+static int gc_regs_count;
 
 static bool active = false;
 static bool doReclaim = false;
 
-#ifdef GC_DEBUG
-int64 t_suspend;
-int64 t_mark;
-int64 t_delete;
-int64 t_regs;
-int64 t_stack;
-#endif
+//concurrent marking (set CCSHARP_GC_CONCURRENT=1)
+static bool gc_concurrent = false;
+static bool gc_cycle_active = false;
+
+//generational collection (set CCSHARP_GC_GENERATIONAL=1)
+//objects are not moved : survivors are promoted in place by setting their old bit
+#define GC_MINOR_MAX 8  //minor collections between major collections
+static bool gc_generational = false;
+static bool gc_minor = false;  //minor collection in progress : only young objects are marked
+static int gc_minor_count = 0;
+static bool doMajor = false;
+static Block *young_list = nullptr;  //blocks that received young objects since last minor collection
+
+namespace Core {
+  volatile bool $gc_marking = false;  //write barrier enabled
+}
+
+//references stored while marking (see Core::$gc_shade)
+static void** shade_list = nullptr;
+static int shade_count = 0;
+static int shade_size = 0;
+static std::atomic_flag shade_lock = ATOMIC_FLAG_INIT;
+
+static inline void GC_shade_lock() {
+  int spins = 0;
+  while (shade_lock.test_and_set(std::memory_order_acquire)) {
+    if (++spins > 100) std::this_thread::yield();
+  }
+}
+
+static inline void GC_shade_unlock() {
+  shade_lock.clear(std::memory_order_release);
+}
+
+//pause times (microseconds)
+static std::chrono::steady_clock::time_point pause_start;
+static int64 pause_last = 0;
+static int64 pause_max = 0;
+static int64 pause_total = 0;
+static int64 pause_count = 0;
+static int64 gc_count = 0;
+
+//telemetry : always on (see System.GC), optional event log (set CCSHARP_GC_LOG=file : one JSON object per line)
+#define PAUSE_BUCKETS 20  //bucket n counts pauses < 2^n microseconds (last bucket counts all longer pauses)
+static int64 pause_hist[PAUSE_BUCKETS];
+static int64 cycle_pause = 0;  //pause time in current cycle
+static int cycle_pauses = 0;  //# of pauses in current cycle
+static int64 gc_minor_total = 0;
+static int64 stat_marked = 0;  //objects marked in current cycle
+static int64 stat_marked_bytes = 0;
+static int64 stat_freed = 0;  //objects freed since current cycle started sweeping
+static int64 stat_freed_bytes = 0;
+static int64 stat_sweep_us = 0;  //time spent sweeping since last collection
+static int64 last_live_bytes = 0;
+static int64 last_collect_us = 0;
+static int64 last_sweep_us = 0;
+static int64 last_freed = 0;
+static int64 last_freed_bytes = 0;
+static thread_local int64 gc_thread_allocated = 0;
+static thread_local int64 gc_thread_allocations = 0;  //objects
+static FILE *gc_log = nullptr;
+static std::chrono::steady_clock::time_point gc_start_time;
+
+//fragmentation : bytes requested vs bytes allocated (size class rounding)
+static int64 alloc_requested = 0;
+static int64 alloc_rounded = 0;
+
+//large object space : free page ranges per large chain
+struct GC_range {
+  int page;
+  int count;
+  GC_range *next;
+};
+
+static GC_range *large_ranges[LARGE_CHAINS];  //free ranges below large_top (sorted by page)
+static int large_top[LARGE_CHAINS];  //first page never used
+static Block *large_free[LARGE_CHAINS];  //released blocks (reused for new large objects)
+static int64 large_bytes = 0;  //bytes in large objects
+static int64 large_limit = LARGE_MIN;
+
+//heap limit (set CCSHARP_GC_MAX_HEAP=bytes with optional K,M,G suffix or call Environment.SetMaxHeap())
+static int64 heap_committed = 0;  //bytes of committed pages (small blocks and large objects)
+static int64 heap_max = 0;  //0 = unlimited
+static System::OutOfMemoryException *gc_oom = nullptr;  //preallocated : there may be no memory left to create it
+
+//scavenger : decommits small object blocks that stay completely free (set CCSHARP_GC_SCAVENGE_MS, 0 = disabled)
+#define SCAVENGE_MS 5000
+#define SCAVENGE_IDLE 2  //passes a block must be free before it is decommitted
+static int gc_scavenge_ms = SCAVENGE_MS;
+static System::Thread *scavenge_thread = nullptr;
+static int64 heap_decommitted = 0;  //total bytes returned to OS
+
+//lazy sweeping : blocks are swept when an allocator first touches them after a collection
+static int gc_sweep_epoch = 1;
+static Block *sweep_next[NUM_CHAINS];  //next block (in block_chains order) that may need sweeping
+
+//finalizer queue : destructors run on the finalizer thread outside of gc_lock
+static System::Mutex *fin_lock;
+static System::Thread *fin_thread = nullptr;
+static Core::Object** fin_list = nullptr;
+static int fin_count = 0;
+static int fin_size = 0;
+static Core::Object** fin_pending = nullptr;
+static int fin_pending_count = 0;
+static int fin_pending_size = 0;
+static Core::Object** fin_running = nullptr;  //batch taken by the finalizer thread, released under gc_lock
+static int fin_running_count = 0;
+//objects of types that declare a destructor (see Core::$gc_finalizable) : the only objects the finalizer ever sees
+static Core::Object** fin_objects = nullptr;
+static int fin_objects_count = 0;
+static int fin_objects_size = 0;
+static std::mutex fin_objects_mutex;
 
 static System::Thread *thread_list = nullptr;
 
 struct GCThread : public System::Thread {
   void Run() override {
+    gc_state = nullptr;  //collector never stops at safepoints
     gc_lock->Lock();
     gc_lock2->Lock();
     gc_lock2->NotifyAll();  //signal main thread that GC thread is running
     gc_lock2->Unlock();
     active = true;
     while (active) {
-      gc_lock->Wait();
+      if (!doReclaim) gc_lock->Wait();
       if (doReclaim) {
         doReclaim = false;
         gc_lock2->Lock();
@@ -152,6 +507,13 @@ struct GCThread : public System::Thread {
   }
 };
 
+//start a collection without waiting for it (gc_lock must be held)
+static void GC_reclaim_async() {
+  if (doReclaim || gc_cycle_active) return;
+  doReclaim = true;
+  gc_lock->NotifyAll();
+}
+
 static void GC_reclaim_signal() {
   gc_lock2->Lock();
   doReclaim = true;
@@ -164,52 +526,326 @@ static void GC_reclaim_signal() {
 
 void System::Environment::Collect() {
   gc_lock->Lock();
+  doMajor = true;
   GC_reclaim_signal();
   gc_lock->Unlock();
 }
 
-static void* GC_malloc_locked(int chain) {
-  Block *blk = block_chains[chain];
-  if (blk == nullptr) return nullptr;
-  while (blk != nullptr) {
-    if (blk->count_free > 0) {
-      int *marks = blk->marks;
-      int count = blk->count;
-      for(int idx=0;idx<count;idx++) {
-        if (marks[idx] == 0) {
-          marks[idx] = gc_mark;
-          blk->count_free--;
-          void* ptr = make_ptr(chain, blk->page_first, idx * blk->size);
-          std::memset(ptr, 0, blk->size);
-          return ptr;
-        }
+void System::Environment::SetMaxHeap(int64 bytes) {
+  gc_lock->Lock();
+  heap_max = bytes;
+  gc_lock->Unlock();
+}
+
+int64 System::Environment::GetMaxHeap() {
+  return heap_max;
+}
+
+static void GC_free_list_add(int chain, Block *blk) {
+  if (chain >= LARGE_CHAIN) return;  //large object blocks are never reused
+  if (blk->in_free_list || blk->decommitted) return;
+  blk->in_free_list = true;
+  blk->next_free = free_chains[chain];
+  free_chains[chain] = blk;
+}
+
+/** Takes a free slot from a chain (gc_lock must be held).
+ * Blocks not swept since the last collection are swept first.
+ */
+static void* GC_reserve_locked(int chain, Block **slot_blk, int *slot_idx) {
+  Block *blk = free_chains[chain];
+  while (blk != nullptr || GC_sweep_next(chain)) {
+    if (blk == nullptr) {
+      blk = free_chains[chain];
+      continue;
+    }
+    GC_sweep_block(chain, blk);
+    int idx = blk->alloc();
+    if (blk->count_free == 0) {
+      //block is full : remove from free list
+      free_chains[chain] = blk->next_free;
+      blk->next_free = nullptr;
+      blk->in_free_list = false;
+    }
+    if (idx != -1) {
+      if (!blk->in_young_list) {
+        blk->in_young_list = true;
+        blk->next_young = young_list;
+        young_list = blk;
       }
+      *slot_blk = blk;
+      *slot_idx = idx;
+      return make_ptr(chain, blk->page_first, idx * blk->size);
     }
-    blk = blk->next;
+    blk = free_chains[chain];
   }
   return nullptr;
 }
 
-static void GC_add_block(int size, int chain) {
+static void GC_add_block(int chain) {
   int page = 0;
   Block *lastblk = block_chains[chain];
   if (lastblk != nullptr) {
     page = lastblk->page_last + 1;
   }
   Block *newblk = new Block();
-  int pages = size / PAGE_SIZE;
-  if (pages < 1) pages = 1;
+  int size = class_size[chain];
+  int pages = class_pages[chain];
   int page_first = Core::OS::AllocateVirtualPages(chain + 1, page, pages);
   int page_last = page_first + pages - 1;
   newblk->init(size, (pages * PAGE_SIZE) / size, page_first, page_last);
+  newblk->chain = chain;
+  newblk->swept = gc_sweep_epoch;
+  heap_committed += pages * PAGE_SIZE;
   newblk->next = lastblk;
   block_chains[chain] = newblk;
+  GC_page_dir_add(chain, newblk);
+  GC_free_list_add(chain, newblk);
+}
+
+//decommit blocks that were completely free for SCAVENGE_IDLE passes (or all free blocks) (gc_lock must be held)
+static void GC_scavenge(bool all) {
+  int64 released = 0;
+  for(int chain=0;chain<SMALL_CHAINS;chain++) {
+    Block **prev = &free_chains[chain];
+    Block *blk = *prev;
+    while (blk != nullptr) {
+      Block *next = blk->next_free;
+      bool empty = blk->count_free == blk->count && blk->swept == gc_sweep_epoch;
+      if (!empty) blk->idle = 0;
+      if (empty && (all || ++blk->idle >= SCAVENGE_IDLE)) {
+        //remove from free list
+        *prev = next;
+        blk->next_free = idle_chains[chain];
+        blk->in_free_list = false;
+        idle_chains[chain] = blk;
+        int pages = blk->page_last - blk->page_first + 1;
+        Core::OS::DecommitVirtualPages(chain + 1, blk->page_first, pages);
+        blk->decommitted = true;
+        heap_committed -= pages * PAGE_SIZE;
+        heap_decommitted += pages * PAGE_SIZE;
+        released += pages * PAGE_SIZE;
+      } else {
+        prev = &blk->next_free;
+      }
+      blk = next;
+    }
+  }
+  if (released > 0 && gc_log != nullptr) {
+    int64 ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - gc_start_time).count();
+    fprintf(gc_log, "{\"event\":\"scavenge\",\"time_ms\":%lld,\"released_bytes\":%lld,\"committed_bytes\":%lld}\n"
+      , ms, released, heap_committed);
+    fflush(gc_log);
+  }
+}
+
+//commit a decommitted block again, returns false if there are none (gc_lock must be held)
+static bool GC_idle_take(int chain) {
+  Block *blk = idle_chains[chain];
+  if (blk == nullptr) return false;
+  idle_chains[chain] = blk->next_free;
+  blk->next_free = nullptr;
+  int pages = blk->page_last - blk->page_first + 1;
+  Core::OS::CommitVirtualPages(chain + 1, blk->page_first, pages);
+  blk->decommitted = false;
+  blk->idle = 0;
+  heap_committed += pages * PAGE_SIZE;
+  GC_free_list_add(chain, blk);
+  return true;
+}
+
+//returns true if heap may grow by bytes
+static inline bool GC_heap_fits(int64 bytes) {
+  return heap_max == 0 || heap_committed + bytes <= heap_max;
+}
+
+//heap limit reached : full collection then release all free blocks (gc_lock must be held)
+static void GC_heap_trim() {
+  if (active) {
+    doMajor = true;
+    GC_reclaim_signal();
+  }
+  GC_sweep_finish();
+  GC_scavenge(true);
 }
 
+struct ScavengerThread : public System::Thread {
+  void Run() override {
+    while (active) {
+      {
+        Core::$GCNative native;
+        std::this_thread::sleep_for(std::chrono::milliseconds(gc_scavenge_ms));
+      }
+      gc_lock->Lock();
+      GC_scavenge(false);
+      gc_lock->Unlock();
+    }
+  }
+};
+
+/** Thread local allocation buffers (small objects only).
+ * Each thread reserves a batch of free slots per chain under gc_lock and then hands them out without locking.
+ * Reserved slots are marked GC_RESERVED so the collector ignores them until they are handed out.
+ */
+
+#define TLAB_CHAINS 32  //16 bytes - 4K
+#define TLAB_BATCH 64  //max slots per chain
+#define TLAB_BYTES (16 * 1024)  //target bytes reserved per refill
+
+struct GC_tlab_slot {
+  void* ptr;
+  Block* blk;
+  int idx;
+};
+
+struct GC_tlab {
+  int64 requested;  //bytes requested since last refill
+  int64 rounded;  //bytes allocated since last refill
+  int count[TLAB_CHAINS];
+  GC_tlab_slot slots[TLAB_CHAINS][TLAB_BATCH];
+};
+
+static thread_local GC_tlab *gc_tlab = nullptr;
+
+struct FinalizerThread : public System::Thread {
+  void Run() override {
+    while (active) {
+      fin_lock->Lock();
+      while (fin_count == 0 && active) {
+        fin_lock->Wait();
+      }
+      Core::Object** list = fin_list;
+      int count = fin_count;
+      fin_list = nullptr;
+      fin_count = 0;
+      fin_size = 0;
+      fin_running = list;
+      fin_running_count = count;
+      fin_lock->Unlock();
+      //run destructors
+      for(int a=0;a<count;a++) {
+        list[a]->~Object();
+      }
+      //release memory
+      gc_lock->Lock();
+      for(int a=0;a<count;a++) {
+        uptr ptr = list[a];
+        int chain = (int)((ptr.v64 & CHAIN_MASK) >> 40) - 1;
+        int page = (int)((ptr.v64 & PAGE_MASK) >> 12);
+        Block *blk = GC_page_dir_get(chain, page);
+        int idx = blk->index(ptr);
+        blk->marks[idx] = GC_FREE;
+        blk->free(idx);
+        if (chain >= LARGE_CHAIN) {
+          GC_large_release(blk);
+        } else {
+          GC_free_list_add(chain, blk);
+        }
+      }
+      fin_running = nullptr;
+      fin_running_count = 0;
+      gc_lock->Unlock();
+      free(list);
+    }
+  }
+};
+
 static bool GC_inited = false;
 
+//allocate safepoint state for a thread (called by the thread itself)
+static void GC_thread_setup(System::Thread *thread) {
+  GC_thread_state *state = new GC_thread_state();
+  state->state.store(GC_RUNNING);
+  state->shade_count = 0;
+  state->regs = new void*[gc_regs_count];
+  std::memset(state->regs, 0, sizeof(void*) * gc_regs_count);
+  thread->GCState = state;
+  gc_state = state;
+}
+
+/** Safepoint slow path : park the thread until the collector is done. */
+void Core::$gc_poll_slow() {
+  GC_thread_state *state = gc_state;
+  if (state == nullptr) return;
+  void* local = nullptr;
+  Core::OS::SaveRegisters(state->regs);
+  System::Thread::Current()->StackCurrent = &local;
+  std::unique_lock<std::mutex> lock(safepoint_mutex);
+  state->state.store(GC_STOPPED);
+  while (Core::$gc_safepoint) {
+    safepoint_cond.wait(lock);
+  }
+  state->state.store(GC_RUNNING);
+}
+
+/** Thread is about to block in native code : the collector will not wait for it. */
+void Core::$gc_enter_native() {
+  GC_thread_state *state = gc_state;
+  if (state == nullptr) return;
+  void* local = nullptr;
+  Core::OS::SaveRegisters(state->regs);
+  System::Thread::Current()->StackCurrent = &local;
+  state->state.store(GC_NATIVE);
+}
+
+/** Thread returns from native code : wait if the collector has stopped the world. */
+void Core::$gc_leave_native() {
+  GC_thread_state *state = gc_state;
+  if (state == nullptr) return;
+  while (true) {
+    state->state.store(GC_RUNNING);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!Core::$gc_safepoint) return;
+    //collector may be scanning this thread : saved registers and stack are still valid
+    state->state.store(GC_NATIVE);
+    std::unique_lock<std::mutex> lock(safepoint_mutex);
+    while (Core::$gc_safepoint) {
+      safepoint_cond.wait(lock);
+    }
+  }
+}
+
+//read a size from the environment (optional K,M,G suffix)
+static int64 GC_env_size(const char* name, int64 def) {
+  const char* str = getenv(name);
+  if (str == nullptr || str[0] == 0) return def;
+  char* end;
+  int64 value = strtoll(str, &end, 10);
+  switch (*end) {
+    case 'k': case 'K': value *= 1024; break;
+    case 'm': case 'M': value *= 1024 * 1024; break;
+    case 'g': case 'G': value *= 1024 * 1024 * 1024; break;
+  }
+  return value;
+}
+
 void Core::Object::GC_init(void *main_stack) {
   std::memset(block_chains, 0, sizeof(Block*) * NUM_CHAINS);
+  std::memset(free_chains, 0, sizeof(Block*) * NUM_CHAINS);
+  std::memset(idle_chains, 0, sizeof(idle_chains));
+  std::memset(page_dir, 0, sizeof(page_dir));
+  std::memset(card_dir, 0, sizeof(card_dir));
+  std::memset(sweep_next, 0, sizeof(Block*) * NUM_CHAINS);
+  std::memset(large_ranges, 0, sizeof(large_ranges));
+  std::memset(large_top, 0, sizeof(large_top));
+  std::memset(large_free, 0, sizeof(large_free));
+  GC_init_classes();
+  const char* concurrent = getenv("CCSHARP_GC_CONCURRENT");
+  gc_concurrent = concurrent != nullptr && concurrent[0] == '1';
+  heap_max = GC_env_size("CCSHARP_GC_MAX_HEAP", 0);
+  gc_scavenge_ms = (int)GC_env_size("CCSHARP_GC_SCAVENGE_MS", SCAVENGE_MS);
+  std::memset(pause_hist, 0, sizeof(pause_hist));
+  gc_start_time = std::chrono::steady_clock::now();
+  const char* log = getenv("CCSHARP_GC_LOG");
+  if (log != nullptr && log[0] != 0) {
+    gc_log = fopen(log, "a");
+    if (gc_log == nullptr) printf("Error:unable to open GC log %s\n", log);
+  }
+  const char* generational = getenv("CCSHARP_GC_GENERATIONAL");
+  gc_generational = generational != nullptr && generational[0] == '1';
+  if (gc_generational) {
+    Core::$gc_cards = card_dir;
+  }
 
   main_thread = new System::Thread();
   main_thread->StackStart = main_stack;
@@ -217,10 +853,11 @@ void Core::Object::GC_init(void *main_stack) {
   main_thread->GC_setup_main_thread();  //setup current_thread
   Core::OS::ThreadGetHandle(main_thread);  //setup NativeHandle
 
-  gc_context_count = Core::OS::GetThreadContextCount();
-  gc_context = new uptr[gc_context_count];
+  gc_regs_count = Core::OS::GetRegisterCount();
+  GC_thread_setup(main_thread);
   gc_lock = new System::Mutex();
   gc_lock2 = new System::Mutex();
+  fin_lock = new System::Mutex();
   GC_inited = true;
   Core::Object::GC_add_static_ref((Core::Object**)&gc_thread);
   gc_thread = new GCThread();  //this will invoke GC_malloc()
@@ -231,6 +868,16 @@ void Core::Object::GC_init(void *main_stack) {
   gc_thread->Start();
   gc_lock2->Wait();  //wait for gc_thread to start
   gc_lock2->Unlock();
+  Core::Object::GC_add_static_ref((Core::Object**)&fin_thread);
+  fin_thread = new FinalizerThread();
+  fin_thread->Start();
+  Core::Object::GC_add_static_ref((Core::Object**)&gc_oom);
+  gc_oom = new System::OutOfMemoryException();
+  if (gc_scavenge_ms > 0) {
+    Core::Object::GC_add_static_ref((Core::Object**)&scavenge_thread);
+    scavenge_thread = new ScavengerThread();
+    scavenge_thread->Start();
+  }
 }
 
 static void GC_uninit() {
@@ -238,137 +885,617 @@ static void GC_uninit() {
   gc_lock->Lock();
   gc_lock->NotifyAll();
   gc_lock->Unlock();
+  fin_lock->Lock();
+  fin_lock->NotifyAll();
+  fin_lock->Unlock();
 }
 
-void* Core::Object::GC_malloc(int size) {
-  if (!GC_inited) {
-    return malloc(size);
+/** Allocates one slot from chain, collecting or growing the heap as required (gc_lock must be held).
+ * Returns nullptr if the heap limit is reached.
+ */
+static void* GC_alloc_slot_locked(int chain, Block **blk, int *idx) {
+  void* ptr = GC_reserve_locked(chain, blk, idx);
+  if (ptr != nullptr) return ptr;
+  if (block_chains[chain] != nullptr) {
+    //no free memory found : try to reclaim some unused memory
+    if (active && gc_concurrent) {
+      //collect in the background and grow the heap meanwhile
+      GC_reclaim_async();
+    } else if (active) {
+      GC_reclaim_signal();
+      ptr = GC_reserve_locked(chain, blk, idx);
+      if (ptr != nullptr) return ptr;
+    }
   }
-  //align size to power of 2
-  if (size > MAX_SIZE) {
-    printf("Fatal Error:GC_mallc() size > MAX_SIZE\n");
-    std::exit(1);
+  //still not available - reuse a decommitted block or add a new block
+  int64 bytes = class_pages[chain] * PAGE_SIZE;
+  if (!GC_heap_fits(bytes)) {
+    GC_heap_trim();
+    ptr = GC_reserve_locked(chain, blk, idx);
+    if (ptr != nullptr) return ptr;
+    if (!GC_heap_fits(bytes)) return nullptr;
   }
-  int p2size = 32;  //smallest size
-  int chain = 0;
-  while (p2size < size) {
-    p2size <<= 1;
-    chain++;
+  if (!GC_idle_take(chain)) {
+    GC_add_block(chain);
   }
-  size = p2size;
+  return GC_reserve_locked(chain, blk, idx);
+}
+
+static void GC_tlab_refill(GC_tlab *tlab, int chain, int size) {
+  int want = TLAB_BYTES / size;
+  if (want > TLAB_BATCH) want = TLAB_BATCH;
+  if (want < 2) want = 2;
+  GC_tlab_slot *slots = tlab->slots[chain];
+  int cnt = 0;
   gc_lock->Lock();
-  if (block_chains[chain] == nullptr) {
-    GC_add_block(size, chain);
-  }
-  void* blk = GC_malloc_locked(chain);
-  if (blk != nullptr) {
+  alloc_requested += tlab->requested;
+  alloc_rounded += tlab->rounded;
+  tlab->requested = 0;
+  tlab->rounded = 0;
+  //first slot may trigger a collection or a new block, the rest only take what is free
+  slots[0].ptr = GC_alloc_slot_locked(chain, &slots[0].blk, &slots[0].idx);
+  if (slots[0].ptr == nullptr) {
     gc_lock->Unlock();
-    return blk;
+    throw gc_oom;
   }
-  //no free memory found : try to reclaim some unused memory
-  if (active) {
-    GC_reclaim_signal();
-    blk = GC_malloc_locked(chain);
+  slots[0].blk->marks[slots[0].idx] = GC_RESERVED;
+  cnt++;
+  while (cnt < want) {
+    GC_tlab_slot *slot = &slots[cnt];
+    slot->ptr = GC_reserve_locked(chain, &slot->blk, &slot->idx);
+    if (slot->ptr == nullptr) break;
+    slot->blk->marks[slot->idx] = GC_RESERVED;
+    cnt++;
+  }
+  gc_lock->Unlock();
+  //hand out lowest addresses first
+  for(int a=0;a<cnt/2;a++) {
+    GC_tlab_slot tmp = slots[a];
+    slots[a] = slots[cnt - 1 - a];
+    slots[cnt - 1 - a] = tmp;
+  }
+  tlab->count[chain] = cnt;
+}
+
+/** Returns reserved slots to the heap (thread is exiting). */
+static void GC_tlab_release(GC_tlab *tlab) {
+  gc_lock->Lock();
+  alloc_requested += tlab->requested;
+  alloc_rounded += tlab->rounded;
+  for(int chain=0;chain<TLAB_CHAINS;chain++) {
+    for(int a=0;a<tlab->count[chain];a++) {
+      GC_tlab_slot *slot = &tlab->slots[chain][a];
+      slot->blk->marks[slot->idx] = GC_FREE;
+      slot->blk->free(slot->idx);
+      GC_free_list_add(chain, slot->blk);
+    }
+    tlab->count[chain] = 0;
+  }
+  gc_lock->Unlock();
+}
+
+/** Marks a new object with the current epoch (allocate black).
+ * The epoch is read again after the store in case the thread was suspended in between and a collection started.
+ */
+static inline void GC_set_alloc_mark(int *mark) {
+  //object must be cleared before the collector can see it
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int epoch = gc_mark;
+  *(volatile int*)mark = epoch;
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int now = gc_mark;
+  if (now != epoch) *(volatile int*)mark = now;
+}
+
+/** Large object space.
+ * Each large object gets its own block with its own pages, the pages are returned to the OS when the object is freed.
+ * Released blocks stay linked in their chain (other lists may still point to them) and are reused for new large objects.
+ */
+
+//find free pages in a large chain (first fit), returns page or -1
+static int GC_large_pages(int k, int pages) {
+  GC_range **prev = &large_ranges[k];
+  GC_range *range = large_ranges[k];
+  while (range != nullptr) {
+    if (range->count >= pages) {
+      int page = range->page;
+      range->page += pages;
+      range->count -= pages;
+      if (range->count == 0) {
+        *prev = range->next;
+        delete range;
+      }
+      return page;
+    }
+    prev = &range->next;
+    range = range->next;
+  }
+  if (large_top[k] + pages > (int)(PAGE_MASK >> 12) + 1) return -1;
+  int page = large_top[k];
+  large_top[k] += pages;
+  return page;
+}
+
+//return pages to a large chain (ranges are merged with neighbours)
+static void GC_large_pages_free(int k, int page, int pages) {
+  GC_range **prev = &large_ranges[k];
+  GC_range *last = nullptr;
+  while (*prev != nullptr && (*prev)->page < page) {
+    last = *prev;
+    prev = &last->next;
+  }
+  GC_range *range = *prev;
+  if (last != nullptr && last->page + last->count == page) {
+    last->count += pages;
+  } else {
+    last = new GC_range();
+    last->page = page;
+    last->count = pages;
+    last->next = range;
+    *prev = last;
+  }
+  if (range != nullptr && last->page + last->count == range->page) {
+    last->count += range->count;
+    last->next = range->next;
+    delete range;
+  }
+  if (last->next == nullptr && last->page + last->count == large_top[k]) {
+    //highest range : lower the top instead
+    large_top[k] = last->page;
+    prev = &large_ranges[k];
+    while (*prev != last) prev = &(*prev)->next;
+    *prev = nullptr;
+    delete last;
+  }
+}
+
+//free pages of a dead large object (gc_lock must be held)
+static void GC_large_release(Block *blk) {
+  int k = blk->chain - LARGE_CHAIN;
+  int pages = blk->page_last - blk->page_first + 1;
+  GC_page_dir_remove(blk->chain, blk);
+  Core::OS::FreeVirtualPages(blk->chain + 1, blk->page_first, pages);
+  GC_large_pages_free(k, blk->page_first, pages);
+  large_bytes -= blk->size;
+  heap_committed -= blk->size;
+  blk->released = true;
+  blk->next_free = large_free[k];
+  large_free[k] = blk;
+}
+
+//sweep all large object blocks (gc_lock must be held)
+static void GC_large_sweep() {
+  for(int chain=LARGE_CHAIN;chain<NUM_CHAINS;chain++) {
+    while (GC_sweep_next(chain)) {}
+  }
+}
+
+//map pages for a large object and assign it a block (gc_lock must be held)
+static Block* GC_large_block(int size) {
+  int pages = size / PAGE_SIZE;
+  for(int k=0;k<LARGE_CHAINS;k++) {
+    int page = GC_large_pages(k, pages);
+    if (page == -1) continue;
+    int chain = LARGE_CHAIN + k;
+    int page_first = Core::OS::AllocateVirtualPages(chain + 1, page, pages);
+    if (page_first != page) {
+      printf("Fatal Error:GC large object pages in use\n");
+      std::exit(1);
+    }
+    Block *blk = large_free[k];
     if (blk != nullptr) {
-      gc_lock->Unlock();
-      return blk;
+      //reuse released block (still linked in block_chains)
+      large_free[k] = blk->next_free;
+      blk->next_free = nullptr;
+      blk->size = size;
+      blk->count_ptrs = size / 8;
+      blk->page_first = page;
+      blk->page_last = page + pages - 1;
+      blk->marks[0] = GC_FREE;
+      blk->free_bits[0] = 1;
+      blk->old_bits[0] = 0;
+      blk->count_free = 1;
+      blk->word_hint = 0;
+      blk->released = false;
+    } else {
+      blk = new Block();
+      blk->init(size, 1, page, page + pages - 1);
+      blk->chain = chain;
+      blk->next = block_chains[chain];
+      block_chains[chain] = blk;
+    }
+    blk->swept = gc_sweep_epoch;
+    GC_page_dir_add(chain, blk);
+    large_bytes += size;
+    heap_committed += size;
+    return blk;
+  }
+  return nullptr;  //large object space exhausted
+}
+
+static void* GC_large_malloc(int size) {
+  gc_lock->Lock();
+  alloc_requested += size;
+  size = (size + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+  alloc_rounded += size;
+  gc_thread_allocated += size;
+  gc_thread_allocations++;
+  GC_large_sweep();
+  if (active && large_bytes + size > large_limit) {
+    //collect before the large object space grows too much
+    if (gc_concurrent) {
+      GC_reclaim_async();
+    } else {
+      GC_reclaim_signal();
+      GC_large_sweep();
+    }
+    large_limit = (large_bytes + size) * 2;
+    if (large_limit < LARGE_MIN) large_limit = LARGE_MIN;
+  }
+  if (!GC_heap_fits(size)) {
+    GC_heap_trim();
+    GC_large_sweep();
+  }
+  Block *blk = GC_heap_fits(size) ? GC_large_block(size) : nullptr;
+  if (blk == nullptr) {
+    gc_lock->Unlock();
+    throw gc_oom;
+  }
+  blk->alloc();
+  if (!blk->in_young_list) {
+    blk->in_young_list = true;
+    blk->next_young = young_list;
+    young_list = blk;
+  }
+  void* ptr = make_ptr(blk->chain, blk->page_first);
+  blk->marks[0] = gc_mark;  //new pages are already zero
+  gc_lock->Unlock();
+  return ptr;
+}
+
+void* Core::Object::GC_malloc(int size) {
+  if (!GC_inited) {
+    return malloc(size);
+  }
+  if (size > MAX_SIZE) {
+    throw gc_oom;
+  }
+  if (size > SMALL_MAX) {
+    return GC_large_malloc(size);
+  }
+  int chain = GC_size_class(size);
+  int request = size;
+  size = class_size[chain];
+  gc_thread_allocated += size;
+  gc_thread_allocations++;
+  if (chain < TLAB_CHAINS) {
+    GC_tlab *tlab = gc_tlab;
+    if (tlab == nullptr) {
+      tlab = new GC_tlab();
+      std::memset(tlab, 0, sizeof(GC_tlab));
+      gc_tlab = tlab;
+    }
+    if (tlab->count[chain] == 0) {
+      GC_tlab_refill(tlab, chain, size);
     }
+    GC_tlab_slot *slot = &tlab->slots[chain][--tlab->count[chain]];
+    tlab->requested += request;
+    tlab->rounded += size;
+    std::memset(slot->ptr, 0, size);
+    GC_set_alloc_mark(&slot->blk->marks[slot->idx]);
+    return slot->ptr;
   }
-  //still not available - add a new block
-  GC_add_block(size, chain);
-  blk = GC_malloc_locked(chain);
-  if (blk != nullptr) {
+  gc_lock->Lock();
+  alloc_requested += request;
+  alloc_rounded += size;
+  Block *blk;
+  int idx;
+  void* ptr = GC_alloc_slot_locked(chain, &blk, &idx);
+  if (ptr == nullptr) {
     gc_lock->Unlock();
-    return blk;
+    throw gc_oom;
   }
-  //Error : should not get here
-  printf("Fatal Error:GC_malloc() failed\n");
-  std::exit(1);
-  return nullptr;
+  std::memset(ptr, 0, size);
+  blk->marks[idx] = gc_mark;
+  gc_lock->Unlock();
+  return ptr;
 }
 
 void System::Thread::GC_add_thread() {
 #ifdef GC_TRACE
   printf("%p GC_add_thread\n", this);
 #endif
+  GC_thread_setup(this);
   gc_lock->Lock();
-  Prev = thread_list;
-  this->Next = thread_list;
+  Prev = nullptr;
+  Next = thread_list;
+  if (thread_list != nullptr) {
+    thread_list->Prev = this;
+  }
   thread_list = this;
   Core::OS::ThreadInit(this);
   gc_lock->Unlock();
 }
 
 void System::Thread::GC_delete_thread() {
+  GC_tlab *tlab = gc_tlab;
+  if (tlab != nullptr) {
+    GC_tlab_release(tlab);
+    gc_tlab = nullptr;
+    delete tlab;
+  }
   gc_lock->Lock();
   if (Prev != nullptr) {
     Prev->Next = Next;
+  } else {
+    thread_list = Next;
   }
   if (Next != nullptr) {
     Next->Prev = Prev;
   }
-  if (thread_list == this) {
-    thread_list = Prev;
-  }
+  Prev = nullptr;
+  Next = nullptr;
   gc_lock->Unlock();
+  //thread is no longer scanned (the collector thread cleared gc_state itself : free its state through GCState)
+  GC_thread_state *state = (GC_thread_state*)GCState;
+  gc_state = nullptr;
+  GCState = nullptr;
+  if (state == nullptr) return;
+  if (state->shade_count > 0) GC_shade_add(state->shade, state->shade_count);
+  delete[] state->regs;
+  delete state;
 }
 
-#ifdef GC_DEBUG
-int64 blocks;
-int64 blocksSize;
-int64 freed;
-int64 freedSize;
-int64 marked;
-int64 markedSize;
-#endif
+/** Object layouts : offsets of reference fields registered by generated library init code.
+ * Objects with a layout only scan their reference fields, all others (arrays, generics, native classes) are scanned conservatively.
+ * Arrays of C# structs register the layout of one element (period) that repeats over the Length elements.
+ */
+struct GC_layout {
+  const std::type_info *type;
+  const std::type_info *base;
+  int size;
+  int *offsets;
+  int count;
+  bool resolved;
+  uint64 *bits;  //1 bit per 8 byte word : 1 = reference (nullptr = conservative)
+  int words;  //# of words described by bits
+  int refs;  //# of reference words
+  int period;  //array of structs : # of words per element (0 = object)
+  int length;  //array of structs : offset of Length
+  int data;  //array of structs : offset of the elements (stored inline after Length)
+  GC_layout *next;
+};
 
-//mark object and everything it references recursively
-void GC_mark_block(uptr ptr, int lvl) {
-  uptr zero = ptr.v64 & ZERO_MASK;
-  if (zero != nullptr) return;
-  uptr chainptr = ptr.v64 & CHAIN_MASK;
-  if (chainptr == nullptr) return;
-  int chain = (int)(chainptr.v64 >> 40) - 1;
+static GC_layout *layout_list = nullptr;
+
+//vptr -> layout cache
+#define LAYOUT_CACHE_SIZE 4096
+#define LAYOUT_CACHE_MASK (LAYOUT_CACHE_SIZE - 1)
+
+struct GC_layout_cache_entry {
+  void* vptr;
+  GC_layout* layout;
+};
+
+static GC_layout_cache_entry layout_cache[LAYOUT_CACHE_SIZE];
+static GC_layout layout_conservative;
+static bool layout_arrays = false;  //struct array layouts registered (primitive arrays must be looked up)
+
+static GC_layout* GC_add_layout(void* type, void* baseType, int size, int* offsets, int count) {
+  GC_layout *layout = new GC_layout();
+  layout->type = (const std::type_info*)type;
+  layout->base = (const std::type_info*)baseType;
+  layout->size = size;
+  layout->offsets = offsets;
+  layout->count = count;
+  layout->resolved = false;
+  layout->bits = nullptr;
+  layout->words = 0;
+  layout->refs = 0;
+  layout->period = 0;
+  layout->length = 0;
+  layout->data = 0;
+  layout->next = layout_list;
+  layout_list = layout;
+  //objects may have been cached as conservative before their type was registered
+  std::memset(layout_cache, 0, sizeof(layout_cache));
+  return layout;
+}
+
+//destructor : unused, objects with a destructor register themselves (see Core::$gc_finalizable)
+void Core::Heap::AddLayout(void* type, void* baseType, int size, int* offsets, int count, bool destructor) {
+  if (GC_inited) gc_lock->Lock();
+  GC_add_layout(type, baseType, size, offsets, count);
+  if (GC_inited) gc_lock->Unlock();
+}
+
+/** Layout of a T[] where T is a C# struct (see Core::$gc_array_layout) : offsets are the reference fields of one element. */
+void Core::$gc_add_array_layout(void* type, int32 lengthOffset, int32 dataOffset, int32 elemSize, int32* offsets, int32 count) {
+  if (GC_inited) gc_lock->Lock();
+  GC_layout *layout = GC_add_layout(type, nullptr, elemSize, offsets, count);
+  layout->length = lengthOffset;
+  layout->data = dataOffset;
+  layout->period = (elemSize + 7) / 8;
+  layout_arrays = true;
+  if (GC_inited) gc_lock->Unlock();
+}
+
+static GC_layout* GC_find_layout(const std::type_info *type) {
+  GC_layout *layout = layout_list;
+  while (layout != nullptr) {
+    if (*layout->type == *type) return layout;
+    layout = layout->next;
+  }
+  return nullptr;
+}
+
+//merge base layouts into a bitmap (layout stays conservative if any base is unknown)
+static void GC_resolve_layout(GC_layout *layout) {
+  if (layout->resolved) return;
+  layout->resolved = true;
+  GC_layout *base = nullptr;
+  if (layout->base != nullptr) {
+    base = GC_find_layout(layout->base);
+    if (base == nullptr) return;
+    GC_resolve_layout(base);
+    if (base->bits == nullptr) return;
+  }
+  int words = (layout->size + 7) / 8;
+  uint64 *bits = new uint64[(words + 63) / 64];
+  std::memset(bits, 0, sizeof(uint64) * ((words + 63) / 64));
+  if (base != nullptr) {
+    std::memcpy(bits, base->bits, sizeof(uint64) * ((base->words + 63) / 64));
+  }
+  for(int a=0;a<layout->count;a++) {
+    int word = layout->offsets[a] / 8;
+    bits[word >> 6] |= 1ULL << (word & 63);
+  }
+  for(int w=0;w<(words + 63) / 64;w++) {
+    layout->refs += GC_popcnt(bits[w]);
+  }
+  layout->words = words;
+  layout->bits = bits;
+}
+
+//returns layout of object or nullptr to scan conservatively
+static GC_layout* GC_get_layout(Core::Object *obj) {
+  void* vptr = *(void**)obj;
+  if (vptr == nullptr) return nullptr;  //not constructed yet
+  int hash = (int)((uptr(vptr).v64 >> 4) & LAYOUT_CACHE_MASK);
+  for(int a=0;a<LAYOUT_CACHE_SIZE;a++) {
+    GC_layout_cache_entry *entry = &layout_cache[(hash + a) & LAYOUT_CACHE_MASK];
+    if (entry->vptr == vptr) {
+      return entry->layout == &layout_conservative ? nullptr : entry->layout;
+    }
+    if (entry->vptr == nullptr) {
+      GC_layout *layout = GC_find_layout(&typeid(*obj));
+      if (layout != nullptr) {
+        GC_resolve_layout(layout);
+        if (layout->bits == nullptr) layout = nullptr;
+      }
+      entry->vptr = vptr;
+      entry->layout = layout == nullptr ? &layout_conservative : layout;
+      return layout;
+    }
+  }
+  return nullptr;  //cache full
+}
+
+/** Mark stack : objects that are marked but whose references have not been scanned yet.
+ * Marking is iterative so deep object graphs (long linked lists) can not overflow the GC thread stack.
+ */
+struct GC_mark_entry {
+  int64 *ptr;
+  int count;  //# of words
+  uint64 *bits;  //reference words (nullptr = all words)
+  int period;  //bits repeat every period words (0 = bits cover all words)
+};
+
+static GC_mark_entry *mark_stack = nullptr;
+static int mark_stack_size = 0;
+static int mark_stack_count = 0;
+
+static void GC_mark_push(int64 *ptr, int count, uint64 *bits, int period = 0) {
+  if (mark_stack_count == mark_stack_size) {
+    int newsize = mark_stack_size == 0 ? 4096 : mark_stack_size * 2;
+    GC_mark_entry *newstack = (GC_mark_entry*)realloc(mark_stack, sizeof(GC_mark_entry) * newsize);
+    if (newstack == nullptr) {
+      printf("Fatal Error:GC mark stack overflow\n");
+      std::exit(1);
+    }
+    mark_stack = newstack;
+    mark_stack_size = newsize;
+  }
+  mark_stack[mark_stack_count].ptr = ptr;
+  mark_stack[mark_stack_count].count = count;
+  mark_stack[mark_stack_count].bits = bits;
+  mark_stack[mark_stack_count].period = period;
+  mark_stack_count++;
+}
+
+//queue object references to be scanned
+static void GC_scan_object(uptr objptr, Block *blk) {
+  Core::Object *obj = (Core::Object*)objptr.vptr;
+  if ((obj->GC_flags & Core::GC_PA) && !layout_arrays) return;  //primitive array : do not scan
+  GC_layout *layout = GC_get_layout(obj);
+  if (layout == nullptr) {
+    if (obj->GC_flags & Core::GC_PA) return;
+    GC_mark_push(objptr.ptr64, blk->count_ptrs, nullptr);
+  } else if (layout->period > 0) {
+    //array of structs : only the reference words of each element
+    if (layout->refs == 0) return;
+    uint8 *base = (uint8*)objptr.vptr;
+    int64 length = *(int32*)(base + layout->length);
+    int64 *data = (int64*)(base + layout->data);
+    int64 max = (blk->size - layout->data) / 8 / layout->period;
+    if (length > max) length = max;
+    if (length > 0) GC_mark_push(data, (int)(length * layout->period), layout->bits, layout->period);
+  } else if (layout->refs > 0) {
+    GC_mark_push(objptr.ptr64, layout->words < blk->count_ptrs ? layout->words : blk->count_ptrs, layout->bits);
+  }
+}
+
+//mark object (if ptr is a valid reference) and queue it to be scanned
+static void GC_mark_ptr(uptr ptr) {
+  uptr zero = ptr.v64 & ZERO_MASK;
+  if (zero != nullptr) return;
+  uptr chainptr = ptr.v64 & CHAIN_MASK;
+  if (chainptr == nullptr) return;
+  int chain = (int)(chainptr.v64 >> 40) - 1;
   if (chain >= NUM_CHAINS) return;
   int page = (int)((ptr.v64 & PAGE_MASK) >> 12);
+  Block *blk = GC_page_dir_get(chain, page);
+  if (blk == nullptr) return;
+  int object = blk->index(ptr);
+  if (object == -1) return;  //unused space at end of block
+  uptr objptr = make_ptr(chain, blk->page_first, object * blk->size);
+  int mark = blk->marks[object];
+  if (mark == GC_FREE || mark == GC_RESERVED || mark == GC_FINALIZE || mark == gc_mark) return;
+  if (gc_minor && blk->is_old(object)) return;  //old objects are assumed live (see GC_mark_cards)
+  blk->marks[object] = gc_mark;
+  stat_marked++;
+  stat_marked_bytes += blk->size;
+  GC_scan_object(objptr, blk);
+}
 
-  Block *blk = block_chains[chain];
-  while (blk != nullptr) {
-    if (page >= blk->page_first && page <= blk->page_last) {
-      //ptr is a valid object reference
-      Core::Object* objptr = (Core::Object*)ptr.vptr;
-      if (chain < 8) {
-        //small object : size <= page
-        int object = (int)((ptr.v64 & OBJ_MASK) >> (chain + 5));
-        if (blk->marks[object] == gc_last) {
-          blk->marks[object] = gc_mark;
-          //now check sub-references
-          if (objptr->GC_flags & Core::GC_PA) return;  //primitive array : do not scan
-          uptr subptr = make_ptr(chain, page);
-          subptr.v64 += object * blk->size;
-          for(int a=0;a<blk->count_ptrs;a++) {
-            GC_mark_block(subptr.get(a), lvl++);
+//scan queued objects until mark stack is empty
+static void GC_mark_drain() {
+  while (mark_stack_count > 0) {
+    mark_stack_count--;
+    int64 *ptr = mark_stack[mark_stack_count].ptr;
+    int count = mark_stack[mark_stack_count].count;
+    uint64 *bits = mark_stack[mark_stack_count].bits;
+    int period = mark_stack[mark_stack_count].period;
+    if (bits == nullptr) {
+      for(int a=0;a<count;a++) {
+        GC_mark_ptr(ptr[a]);
+      }
+    } else if (period > 0) {
+      //array of structs : same bits for every element
+      int words = (period + 63) / 64;
+      for(int e=0;e + period <= count;e += period) {
+        for(int w=0;w<words;w++) {
+          uint64 refs = bits[w];
+          while (refs != 0) {
+            int a = (w << 6) + GC_ctz(refs);
+            refs &= refs - 1;
+            GC_mark_ptr(ptr[e + a]);
           }
         }
-      } else {
-        //large object (multiple pages)
-        if (blk->marks[0] == gc_last) {
-          blk->marks[0] = gc_mark;
-          //now check sub-references (large)
-          if (objptr->GC_flags & Core::GC_PA) return;  //primitive array : do not scan
-          uptr subptr = make_ptr(chain, page);
-          for(int a=0;a<blk->count_ptrs;a++) {
-            GC_mark_block(subptr.get(a), lvl++);
-          }
+      }
+    } else {
+      //precise : only visit reference fields
+      int words = (count + 63) / 64;
+      for(int w=0;w<words;w++) {
+        uint64 refs = bits[w];
+        while (refs != 0) {
+          int a = (w << 6) + GC_ctz(refs);
+          refs &= refs - 1;
+          if (a >= count) break;
+          GC_mark_ptr(ptr[a]);
         }
       }
-#ifdef GC_DEBUG
-      marked++;
-      markedSize += blk->size;
-#endif
-      break;
     }
-    blk = blk->next;
   }
 }
 
@@ -378,7 +1505,7 @@ static void GC_mark_static_list() {
 #ifdef GC_TRACE
     printf("%p static\n", *ref->ref);
 #endif
-    GC_mark_block(*ref->ref, 1);
+    GC_mark_ptr(*ref->ref);
     ref = ref->next;
   }
 }
@@ -389,161 +1516,698 @@ static void GC_mark_thread_list() {
 #ifdef GC_TRACE
     printf("%p thread mark\n", ref);
 #endif
-    GC_mark_block(ref, 1);
+    GC_mark_ptr(ref);
     ref = ref->Next;
   }
 }
 
-static void GC_reclaim_locked() {
-#ifdef GC_DEBUG
-  int64 start, end;
-  blocks = 0;
-  blocksSize = 0;
-  freed = 0;
-  freedSize = 0;
-  marked = 0;
-  markedSize = 0;
-#endif
-#ifdef GC_TRACE
-  printf("%p GC_reclaim\n", System::Thread::Current());
-#endif
-  gc_last = gc_mark;
-  gc_mark++;
-  if (gc_mark == 0x7fffffff) gc_mark = 1;
-  //mark static fields using GC_static_list
-#ifdef GC_DEBUG
-  start = System::DateTime::CurrentTimeEpoch();
-#endif
-  GC_mark_static_list();
-  GC_mark_thread_list();
-  //stop all threads
-#ifdef GC_DEBUG
-  end = System::DateTime::CurrentTimeEpoch();
-  t_mark = end - start;
-  start = System::DateTime::CurrentTimeEpoch();
-#endif
+//stop all threads (threads allocate without gc_lock so all roots must be scanned while stopped)
+static void GC_suspend_all() {
+  pause_start = std::chrono::steady_clock::now();
+  Core::$gc_safepoint = true;
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  //wait for every thread to reach a safepoint or native code
   System::Thread *thread = thread_list;
   while (thread != nullptr) {
-    if (thread != gc_thread) {
+    GC_thread_state *state = (GC_thread_state*)thread->GCState;
+    if (thread != gc_thread && state != nullptr) {
 #ifdef GC_TRACE
       printf("%p suspend\n", thread);
 #endif
-      Core::OS::ThreadSuspend(thread);
+      int spins = 0;
+      while (state->state.load() == GC_RUNNING) {
+        if (++spins > 100) std::this_thread::yield();
+      }
     }
     thread = thread->Next;
   }
-  //scan all threads for references
-  thread = thread_list;
+}
+
+static void GC_resume_all() {
+  {
+    std::lock_guard<std::mutex> lock(safepoint_mutex);
+    Core::$gc_safepoint = false;
+  }
+  safepoint_cond.notify_all();
+  int64 us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - pause_start).count();
+  pause_last = us;
+  if (us > pause_max) pause_max = us;
+  pause_total += us;
+  pause_count++;
+  int bucket = us == 0 ? 0 : GC_log2(us) + 1;
+  if (bucket >= PAUSE_BUCKETS) bucket = PAUSE_BUCKETS - 1;
+  pause_hist[bucket]++;
+  cycle_pause += us;
+  cycle_pauses++;
+}
+
+//mark roots : static fields, thread list, registers and stacks (threads must be suspended)
+static void GC_mark_roots() {
+  GC_mark_static_list();
+  GC_mark_thread_list();
+  System::Thread *thread = thread_list;
   while (thread != nullptr) {
     if (thread != gc_thread) {
-#ifdef GC_TRACE
-      printf("%p get context\n", thread);
-#endif
-      //get thread context (registers)
-      Core::OS::GetThreadContext(thread, (void**)gc_context);
 #ifdef GC_TRACE
       printf("%p thread stack : %p - %p\n", thread, thread->StackStart, thread->StackCurrent);
 #endif
-#ifdef GC_DEBUG
-      start = System::DateTime::CurrentTimeEpoch();
-#endif
-      for(int a=0;a<gc_context_count;a++) {
-        uptr ptr = gc_context[a];
-        GC_mark_block(ptr, 0);
+      //registers saved when thread stopped
+      GC_thread_state *state = (GC_thread_state*)thread->GCState;
+      if (state != nullptr) {
+        for(int a=0;a<gc_regs_count;a++) {
+          GC_mark_ptr(state->regs[a]);
+        }
       }
-#ifdef GC_DEBUG
-      end = System::DateTime::CurrentTimeEpoch();
-      t_regs = end - start;
-      start = System::DateTime::CurrentTimeEpoch();
-#endif
       //check thread stack
       uptr StackStart = thread->StackStart;
-      if (StackStart.vptr == nullptr) continue;  //not running yet
       uptr stack_current = thread->StackCurrent;
-      if (stack_current == nullptr) {
+      if (StackStart.vptr == nullptr) {
+        //not running yet
+      } else if (stack_current == nullptr) {
 #ifdef GC_TRACE
         printf("%p : thread invalid stack current\n", thread);
 #endif
-        continue;
-      }
-      int pos = 0;
-      while (stack_current.vptr < StackStart.vptr) {
-        uptr ptr = stack_current.get(0);
-        GC_mark_block(ptr, 0);
-        stack_current.ptr64++;
+      } else {
+        while (stack_current.vptr < StackStart.vptr) {
+          GC_mark_ptr(stack_current.get(0));
+          stack_current.ptr64++;
+        }
       }
     }
     thread = thread->Next;
   }
-#ifdef GC_DEBUG
-  end = System::DateTime::CurrentTimeEpoch();
-  t_stack = end - start;
-#endif
-  //resume all threads
-  thread = thread_list;
+}
+
+//append references to shade_list
+static void GC_shade_add(void** ptrs, int count) {
+  GC_shade_lock();
+  if (shade_count + count > shade_size) {
+    int newsize = shade_size == 0 ? 1024 : shade_size * 2;
+    while (newsize < shade_count + count) newsize *= 2;
+    void** newlist = (void**)realloc(shade_list, sizeof(void*) * newsize);
+    if (newlist == nullptr) {
+      printf("Fatal Error:GC shade list overflow\n");
+      std::exit(1);
+    }
+    shade_list = newlist;
+    shade_size = newsize;
+  }
+  std::memcpy(shade_list + shade_count, ptrs, sizeof(void*) * count);
+  shade_count += count;
+  GC_shade_unlock();
+}
+
+//move partial thread shade buffers to shade_list (threads must be suspended)
+static void GC_shade_collect() {
+  System::Thread *thread = thread_list;
   while (thread != nullptr) {
-    if (thread != gc_thread) {
-      Core::OS::ThreadResume(thread);
+    GC_thread_state *state = (GC_thread_state*)thread->GCState;
+    if (state != nullptr && state->shade_count > 0) {
+      GC_shade_add(state->shade, state->shade_count);
+      state->shade_count = 0;
     }
     thread = thread->Next;
   }
-#ifdef GC_DEBUG
-  end = System::DateTime::CurrentTimeEpoch();
-  t_suspend = end - start;
-  start = System::DateTime::CurrentTimeEpoch();
-#endif
-  //now walk through objects and delete any without current mark
+}
+
+//true if ptr is a heap object already marked in the current cycle (hint : read without gc_lock)
+static bool GC_is_marked(void* vptr) {
+  uptr ptr;
+  ptr.vptr = vptr;
+  if ((ptr.v64 & ZERO_MASK) != 0) return false;
+  int chain = (int)((ptr.v64 & CHAIN_MASK) >> 40) - 1;
+  if (chain < 0 || chain >= NUM_CHAINS) return false;
+  Block *blk = GC_page_dir_get(chain, (int)((ptr.v64 & PAGE_MASK) >> 12));
+  if (blk == nullptr) return false;
+  int idx = blk->index(ptr);
+  return idx != -1 && blk->marks[idx] == gc_mark;
+}
+
+//mark references stored by mutators while marking (see Core::$wb)
+static bool GC_mark_shaded() {
+  GC_shade_lock();
+  int count = shade_count;
+  void** list = shade_list;
+  shade_list = nullptr;
+  shade_count = 0;
+  shade_size = 0;
+  GC_shade_unlock();
+  for(int a=0;a<count;a++) {
+    GC_mark_ptr(list[a]);
+  }
+  free(list);
+  return count > 0;
+}
+
+static void GC_next_epoch() {
+  if (gc_mark == 0x7fffffff) gc_mark = 1; else gc_mark = gc_mark + 1;
+}
+
+static void GC_mark_finalizable();
+static void GC_fin_flush();
+
+//mark with all threads stopped
+static void GC_mark_stw() {
+  GC_suspend_all();
+  GC_next_epoch();
+  GC_mark_roots();
+  GC_mark_drain();
+  GC_mark_finalizable();
+  GC_resume_all();
+  GC_fin_flush();
+}
+
+//mark while threads keep running : only the root scans are done with threads stopped
+static void GC_mark_concurrent() {
+  GC_suspend_all();
+  GC_next_epoch();
+  Core::$gc_marking = true;
+  GC_mark_roots();
+  GC_resume_all();
+  //release locks so threads can allocate (new blocks are added instead of collecting)
+  gc_lock2->Unlock();
+  gc_lock->Unlock();
+  do {
+    GC_mark_drain();
+  } while (GC_mark_shaded());
+  gc_lock->Lock();
+  gc_lock2->Lock();
+  //rescan roots that changed without a write barrier (stacks, registers, static fields)
+  GC_suspend_all();
+  GC_shade_collect();
+  GC_mark_roots();
+  do {
+    GC_mark_drain();
+  } while (GC_mark_shaded());
+  GC_mark_finalizable();
+  Core::$gc_marking = false;
+  GC_resume_all();
+  GC_fin_flush();
+}
+
+//scan old objects in pages with dirty cards for references to young objects
+static void GC_mark_cards() {
   for(int chain=0;chain<NUM_CHAINS;chain++) {
     Block *blk = block_chains[chain];
     while (blk != nullptr) {
-#ifdef GC_DEBUG
-      blocks += blk->count;
-      blocksSize += blk->count * blk->size;
+      if (blk->released) {
+        blk = blk->next;
+        continue;
+      }
+      bool dirty = false;
+      for(int page=blk->page_first;page<=blk->page_last;page++) {
+        if (GC_card_dirty(chain, page)) {
+          dirty = true;
+          break;
+        }
+      }
+      if (dirty) {
+        for(int idx=0;idx<blk->count;idx++) {
+          if (!blk->is_old(idx)) continue;
+          int mark = blk->marks[idx];
+          if (mark == GC_FREE || mark == GC_RESERVED || mark == GC_FINALIZE) continue;
+          GC_scan_object(make_ptr(chain, blk->page_first, idx * blk->size), blk);
+        }
+      }
+      blk = blk->next;
+    }
+  }
+}
+
+//add object to finalizer queue (fin_lock must be held)
+static void GC_fin_append(Core::Object *obj) {
+  if (fin_count == fin_size) {
+    int newsize = fin_size == 0 ? 1024 : fin_size * 2;
+    Core::Object** newlist = (Core::Object**)realloc(fin_list, sizeof(Core::Object*) * newsize);
+    if (newlist == nullptr) {
+      printf("Fatal Error:GC finalizer queue overflow\n");
+      std::exit(1);
+    }
+    fin_list = newlist;
+    fin_size = newsize;
+  }
+  fin_list[fin_count++] = obj;
+}
+
+//threads are suspended (finalizer thread may hold fin_lock) : queued later by GC_fin_flush
+static void GC_fin_add(Core::Object *obj) {
+  if (fin_pending_count == fin_pending_size) {
+    fin_pending_size = fin_pending_size == 0 ? 1024 : fin_pending_size * 2;
+    fin_pending = (Core::Object**)realloc(fin_pending, sizeof(Core::Object*) * fin_pending_size);
+  }
+  fin_pending[fin_pending_count++] = obj;
+}
+
+//queue dead object with a destructor for the finalizer
+static void GC_fin_queue(Core::Object *obj, Block *blk, int idx) {
+  stat_freed++;
+  stat_freed_bytes += blk->size;
+  blk->marks[idx] = GC_FINALIZE;
+  GC_fin_add(obj);
+}
+
+//scan objects in a finalizer queue
+static void GC_scan_queued(Core::Object** list, int count) {
+  for(int a=0;a<count;a++) {
+    uptr ptr = list[a];
+    int chain = (int)((ptr.v64 & CHAIN_MASK) >> 40) - 1;
+    GC_scan_object(ptr, GC_page_dir_get(chain, (int)((ptr.v64 & PAGE_MASK) >> 12)));
+  }
+}
+
+/** Keeps everything reachable from objects waiting for their destructor alive (threads must be suspended).
+ * Only the registered objects (fin_objects) and the finalizer queues are visited, never the whole heap.
+ * Dead registered objects are queued first (GC_mark_ptr skips GC_FINALIZE so cycles through them are still queued),
+ * then the references of all queued objects are marked until the destructor has run and the finalizer released them.
+ */
+static void GC_mark_finalizable() {
+  int kept = 0;
+  for(int a=0;a<fin_objects_count;a++) {
+    Core::Object *obj = fin_objects[a];
+    uptr ptr = obj;
+    int chain = (int)((ptr.v64 & CHAIN_MASK) >> 40) - 1;
+    Block *blk = GC_page_dir_get(chain, (int)((ptr.v64 & PAGE_MASK) >> 12));
+    int idx = blk->index(ptr);
+    int mark = blk->marks[idx];
+    if (mark == GC_FINALIZE) continue;  //registered twice (base and derived destructors)
+    if (mark == gc_mark || (gc_minor && blk->is_old(idx))) {
+      fin_objects[kept++] = obj;
+      continue;
+    }
+    GC_fin_queue(obj, blk, idx);
+  }
+  fin_objects_count = kept;
+  GC_scan_queued(fin_pending, fin_pending_count);  //queued by this collection
+  GC_scan_queued(fin_list, fin_count);  //waiting for the finalizer thread
+  GC_scan_queued(fin_running, fin_running_count);  //destructors running
+  GC_mark_drain();
+}
+
+//free a dead object (objects with a destructor were queued by GC_mark_finalizable)
+static void GC_free_object(int chain, Block *blk, int idx) {
+  stat_freed++;
+  stat_freed_bytes += blk->size;
+  Core::Object *obj = (Core::Object*)make_ptr(chain, blk->page_first, idx * blk->size);
+#ifdef GC_TRACE
+  printf("%p delete it\n", obj);
 #endif
-      for(int idx=0;idx < blk->count;idx++) {
+  blk->marks[idx] = GC_FREE;
+  blk->free(idx);
+  if (chain >= LARGE_CHAIN) GC_large_release(blk);
+}
+
+//queue objects found dead while threads were suspended
+static void GC_fin_flush() {
+  if (fin_pending_count == 0) return;
+  //one batch : destructors may still use other objects queued in the same collection
+  fin_lock->Lock();
+  for(int a=0;a<fin_pending_count;a++) {
+    GC_fin_append(fin_pending[a]);
+  }
+  fin_pending_count = 0;
+  fin_lock->NotifyAll();
+  fin_lock->Unlock();
+}
+
+//delete objects in block without current mark (gc_lock must be held)
+static void GC_sweep_block(int chain, Block *blk) {
+  if (blk->swept == gc_sweep_epoch) return;
+  blk->swept = gc_sweep_epoch;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  //only visit allocated objects (clear bits in free_bits)
+  for(int w=0;w<blk->words;w++) {
+    uint64 used = ~blk->free_bits[w];
+    if (w == blk->words - 1 && blk->count % 64 != 0) {
+      used &= (1ULL << (blk->count % 64)) - 1;
+    }
+    while (used != 0) {
+      int idx = (w << 6) + GC_ctz(used);
+      used &= used - 1;
+      int mark = blk->marks[idx];
+      if (mark == GC_RESERVED || mark == GC_FINALIZE) continue;  //owned by a thread allocation buffer or finalizer
+      if (mark != gc_mark) {
+        GC_free_object(chain, blk, idx);
+      }
+    }
+  }
+  stat_sweep_us += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+  if (blk->count_free > 0) {
+    GC_free_list_add(chain, blk);
+  }
+}
+
+//sweep the next unswept block in chain, returns false when the chain is fully swept
+static bool GC_sweep_next(int chain) {
+  while (sweep_next[chain] != nullptr) {
+    Block *blk = sweep_next[chain];
+    sweep_next[chain] = blk->next;
+    if (blk->swept == gc_sweep_epoch) continue;
+    GC_sweep_block(chain, blk);
+    return true;
+  }
+  return false;
+}
+
+//finish sweeping of previous collection (marks must not change while blocks are unswept)
+static void GC_sweep_finish() {
+  for(int chain=0;chain<NUM_CHAINS;chain++) {
+    while (GC_sweep_next(chain)) {}
+  }
+}
+
+//start lazy sweeping after marking
+static void GC_sweep_start() {
+  gc_sweep_epoch++;
+  for(int chain=0;chain<NUM_CHAINS;chain++) {
+    sweep_next[chain] = block_chains[chain];
+  }
+}
+
+//free unmarked young objects and promote the rest (gc_lock must be held)
+static void GC_sweep_young() {
+  Block *blk = young_list;
+  young_list = nullptr;
+  while (blk != nullptr) {
+    Block *next = blk->next_young;
+    bool reserved = false;
+    for(int w=0;w<blk->words;w++) {
+      //allocated young objects
+      uint64 used = ~blk->free_bits[w] & ~blk->old_bits[w];
+      if (w == blk->words - 1 && blk->count % 64 != 0) {
+        used &= (1ULL << (blk->count % 64)) - 1;
+      }
+      while (used != 0) {
+        int idx = (w << 6) + GC_ctz(used);
+        used &= used - 1;
         int mark = blk->marks[idx];
-        if (mark != 0 && mark != gc_mark) {
-        //delete block
-#ifdef GC_DEBUG
-          freed++;
-          freedSize += blk->size;
-#endif
-          Core::Object *obj = (Core::Object*)make_ptr(chain, blk->page_first, idx * blk->size);
+        if (mark == GC_RESERVED) {
+          reserved = true;
+          continue;
+        }
+        if (mark == GC_FINALIZE) continue;
+        if (mark == gc_mark) {
+          blk->set_old(idx);
+          continue;
+        }
+        GC_free_object(blk->chain, blk, idx);
+      }
+    }
+    if (blk->count_free > 0) {
+      GC_free_list_add(blk->chain, blk);
+    }
+    if (reserved) {
+      //keep block : thread allocation buffers still own young slots
+      blk->next_young = young_list;
+      young_list = blk;
+    } else {
+      blk->in_young_list = false;
+      blk->next_young = nullptr;
+    }
+    blk = next;
+  }
+}
+
+/** Collects young objects only (threads are stopped).
+ * Roots and old objects in dirty cards are scanned, young objects are then freed or promoted.
+ * Sweeping is done before threads resume so objects allocated after marking are never promoted untraced.
+ */
+static void GC_collect_minor() {
+  GC_suspend_all();
+  GC_next_epoch();
+  gc_minor = true;
+  GC_mark_roots();
+  GC_mark_cards();
+  GC_mark_drain();
+  GC_mark_finalizable();
+  gc_minor = false;
+  GC_cards_clear();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  GC_sweep_young();
+  stat_sweep_us += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+  GC_resume_all();
+  GC_fin_flush();
+}
+
+static void GC_heap_sizes(int64 *heap, int64 *used);
+
+//append one event to the GC log (gc_lock must be held)
+//sweep and freed counts cover the time since the previous event (sweeping is lazy)
+static void GC_log_cycle(bool minor, int64 collect_us) {
+  int64 heap, used;
+  GC_heap_sizes(&heap, &used);
+  int64 ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - gc_start_time).count();
+  fprintf(gc_log, "{\"event\":\"gc\",\"time_ms\":%lld,\"gc\":%lld,\"kind\":\"%s\",\"concurrent\":%s"
+    ",\"pause_us\":%lld,\"pauses\":%d,\"collect_us\":%lld,\"marked\":%lld,\"marked_bytes\":%lld"
+    ",\"sweep_us\":%lld,\"freed\":%lld,\"freed_bytes\":%lld"
+    ",\"heap_bytes\":%lld,\"used_bytes\":%lld,\"committed_bytes\":%lld,\"large_bytes\":%lld}\n"
+    , ms, gc_count, minor ? "minor" : "major", (!minor && gc_concurrent) ? "true" : "false"
+    , cycle_pause, cycle_pauses, collect_us, stat_marked, stat_marked_bytes
+    , last_sweep_us, last_freed, last_freed_bytes
+    , heap, used, heap_committed, large_bytes);
+  fflush(gc_log);
+}
+
+static void GC_reclaim_locked() {
 #ifdef GC_TRACE
-          printf("%p delete it\n", obj);
+  printf("%p GC_reclaim\n", System::Thread::Current());
 #endif
-          delete obj;
-          blk->marks[idx] = 0;
-          blk->count_free++;
-        }
+  gc_cycle_active = true;
+  GC_sweep_finish();
+  //sweeping of previous cycle is complete
+  last_sweep_us = stat_sweep_us;
+  last_freed = stat_freed;
+  last_freed_bytes = stat_freed_bytes;
+  stat_sweep_us = 0;
+  stat_freed = 0;
+  stat_freed_bytes = 0;
+  stat_marked = 0;
+  stat_marked_bytes = 0;
+  cycle_pause = 0;
+  cycle_pauses = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  bool minor = gc_generational && !doMajor && gc_minor_count < GC_MINOR_MAX;
+  if (minor) {
+    gc_minor_count++;
+    gc_minor_total++;
+    GC_collect_minor();
+    int64 heap;
+    GC_heap_sizes(&heap, &last_live_bytes);  //young objects are already swept
+  } else {
+    doMajor = false;
+    gc_minor_count = 0;
+    if (gc_concurrent) {
+      GC_mark_concurrent();
+    } else {
+      GC_mark_stw();
+    }
+    GC_sweep_start();
+    last_live_bytes = stat_marked_bytes;
+  }
+  last_collect_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+  gc_cycle_active = false;
+  gc_count++;
+  if (gc_log != nullptr) {
+    GC_log_cycle(minor, last_collect_us);
+  }
+}
+
+/** Called by the generated $init() of a class that declares a destructor : only registered objects are finalized. */
+void Core::$gc_finalizable(void* obj) {
+  std::lock_guard<std::mutex> lock(fin_objects_mutex);
+  if (fin_objects_count == fin_objects_size) {
+    int newsize = fin_objects_size == 0 ? 1024 : fin_objects_size * 2;
+    Core::Object** newlist = (Core::Object**)realloc(fin_objects, sizeof(Core::Object*) * newsize);
+    if (newlist == nullptr) {
+      printf("Fatal Error:GC finalizer registry overflow\n");
+      std::exit(1);
+    }
+    fin_objects = newlist;
+    fin_objects_size = newsize;
+  }
+  fin_objects[fin_objects_count++] = (Core::Object*)obj;
+}
+
+/** Write barrier slow path : records a reference stored while the collector is marking.
+ * Objects already marked in this cycle are skipped, others go into the thread's buffer
+ * (one shade_lock per SHADE_BATCH stores, the collector takes partial buffers while threads are stopped).
+ */
+void Core::$gc_shade(void* ptr) {
+  if (ptr == nullptr) return;
+  if (GC_is_marked(ptr)) return;
+  GC_thread_state *state = gc_state;
+  if (state == nullptr) {
+    GC_shade_add(&ptr, 1);  //collector or finalizer thread : no buffer
+    return;
+  }
+  state->shade[state->shade_count++] = ptr;
+  if (state->shade_count == SHADE_BATCH) {
+    GC_shade_add(state->shade, SHADE_BATCH);
+    state->shade_count = 0;
+  }
+}
+
+bool System::GC::IsConcurrent() {
+  return gc_concurrent;
+}
+
+int64 System::GC::CollectionCount() {
+  return gc_count;
+}
+
+int64 System::GC::GetLastPause() {
+  return pause_last;
+}
+
+int64 System::GC::GetMaxPause() {
+  return pause_max;
+}
+
+int64 System::GC::GetTotalPause() {
+  return pause_total;
+}
+
+int64 System::GC::GetPauseCount() {
+  return pause_count;
+}
+
+void System::GC::ResetPauses() {
+  gc_lock->Lock();
+  pause_last = 0;
+  pause_max = 0;
+  pause_total = 0;
+  pause_count = 0;
+  std::memset(pause_hist, 0, sizeof(pause_hist));
+  gc_lock->Unlock();
+}
+
+int32 System::GC::GetPauseBucketCount() {
+  return PAUSE_BUCKETS;
+}
+
+int64 System::GC::GetPauseHistogram(int32 bucket) {
+  if (bucket < 0 || bucket >= PAUSE_BUCKETS) return 0;
+  return pause_hist[bucket];
+}
+
+int64 System::GC::MinorCollectionCount() {
+  return gc_minor_total;
+}
+
+int64 System::GC::GetLastCollectTime() {
+  return last_collect_us;
+}
+
+int64 System::GC::GetLastSweepTime() {
+  return last_sweep_us;
+}
+
+int64 System::GC::GetLastFreedBytes() {
+  return last_freed_bytes;
+}
+
+int64 System::GC::GetLiveBytes() {
+  return last_live_bytes;
+}
+
+int64 System::GC::GetTotalAllocatedBytes() {
+  gc_lock->Lock();
+  int64 bytes = alloc_rounded;
+  gc_lock->Unlock();
+  return bytes;
+}
+
+int64 System::GC::GetAllocatedBytesForCurrentThread() {
+  return gc_thread_allocated;
+}
+
+int64 System::GC::GetAllocationCountForCurrentThread() {
+  return gc_thread_allocations;
+}
+
+int32 System::GC::GetSizeClassCount() {
+  return SMALL_CHAINS + 1;
+}
+
+int32 System::GC::GetSizeClassSize(int32 cls) {
+  if (cls < 0 || cls >= SMALL_CHAINS) return 0;
+  return class_size[cls];
+}
+
+//bytes in blocks of a size class (last class = all large objects)
+static void GC_class_sizes(int32 cls, int64 *heap, int64 *used) {
+  *heap = 0;
+  *used = 0;
+  if (cls < 0 || cls > SMALL_CHAINS) return;
+  int first = cls;
+  int last = cls == SMALL_CHAINS ? NUM_CHAINS - 1 : cls;
+  for(int chain=first;chain<=last;chain++) {
+    Block *blk = block_chains[chain];
+    while (blk != nullptr) {
+      if (!blk->released && !blk->decommitted) {
+        *heap += (int64)(blk->page_last - blk->page_first + 1) * PAGE_SIZE;
+        *used += (int64)(blk->count - blk->count_free) * blk->size;
       }
       blk = blk->next;
     }
   }
-#ifdef GC_DEBUG
-  end = System::DateTime::CurrentTimeEpoch();
-  t_delete = end - start;
-  printf("gc:blks=%lld size=%lld free=%lld size=%lld mark=%lld size=%lld\n"
-    , blocks, blocksSize, freed, freedSize, marked, markedSize);
-  printf("gc:chains:");
+}
+
+int64 System::GC::GetSizeClassHeap(int32 cls) {
+  int64 heap, used;
+  gc_lock->Lock();
+  GC_class_sizes(cls, &heap, &used);
+  gc_lock->Unlock();
+  return heap;
+}
+
+int64 System::GC::GetSizeClassUsed(int32 cls) {
+  int64 heap, used;
+  gc_lock->Lock();
+  GC_class_sizes(cls, &heap, &used);
+  gc_lock->Unlock();
+  return used;
+}
+
+//sum block sizes (gc_lock must be held)
+static void GC_heap_sizes(int64 *heap, int64 *used) {
+  *heap = 0;
+  *used = 0;
   for(int chain=0;chain<NUM_CHAINS;chain++) {
-    int blk_count = 0;
-    int obj_count = 0;
-    int obj_size = 0;
     Block *blk = block_chains[chain];
     while (blk != nullptr) {
-      blk_count++;
-      obj_count += blk->count;
-      obj_size = blk->size;
+      if (!blk->released && !blk->decommitted) {
+        *heap += (int64)(blk->page_last - blk->page_first + 1) * PAGE_SIZE;
+        *used += (int64)(blk->count - blk->count_free) * blk->size;
+      }
       blk = blk->next;
     }
-    if (blk_count > 0) {
-      printf("%d %d %d %d:", chain, obj_size, blk_count, obj_count);
-    }
   }
-  printf("\n");
-  printf("gc:ms suspend=%lld mark=%lld delete=%lld regs=%lld stack=%lld\n", t_suspend, t_mark, t_delete, t_regs, t_stack);
-#endif
+}
+
+int64 System::GC::GetHeapSize() {
+  int64 heap, used;
+  gc_lock->Lock();
+  GC_heap_sizes(&heap, &used);
+  gc_lock->Unlock();
+  return heap;
+}
+
+int64 System::GC::GetHeapUsed() {
+  int64 heap, used;
+  gc_lock->Lock();
+  GC_heap_sizes(&heap, &used);
+  gc_lock->Unlock();
+  return used;
+}
+
+int64 System::GC::GetFragmentation() {
+  int64 heap, used;
+  gc_lock->Lock();
+  GC_heap_sizes(&heap, &used);
+  double rounding = alloc_rounded == 0 ? 1.0 : (double)alloc_requested / (double)alloc_rounded;
+  gc_lock->Unlock();
+  if (heap == 0) return 0;
+  return (int64)(1000.0 - (used * rounding) * 1000.0 / (double)heap);
 }
 
 //TODO : static_list should be PER library so they can be unloaded
@@ -564,6 +2228,15 @@ void Core::Object::operator delete(void* ptr) {
 
 Core::Object::~Object() {}
 
+//objects never move : the address is a stable identity (mixed so aligned addresses spread over all bits)
+int32 System::Object::GetHashCode() {
+  uint64 h = (uint64)this;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return (int32)h;
+}
+
 namespace Core {
 
   int g_argc;
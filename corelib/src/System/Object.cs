@@ -3,5 +3,7 @@ namespace System {
     public Object() {}
     public extern virtual Type GetType();
     public virtual String ToString() {return "Object";}
+    public virtual bool Equals(Object obj) {return this == obj;}
+    public extern virtual int GetHashCode();  //identity (objects never move)
   }
 }
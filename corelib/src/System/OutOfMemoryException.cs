@@ -0,0 +1,7 @@
+namespace System {
+  public class OutOfMemoryException : Exception {
+    public OutOfMemoryException() {}
+    public OutOfMemoryException(String msg) : base(msg) {
+    }
+  }
+}
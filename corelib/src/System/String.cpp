@@ -1,3 +1,185 @@
+#include <cstring>
+#include <mutex>
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define STRING_SSE2
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define STRING_AVX2_FUNC
+#else
+#define STRING_AVX2_FUNC __attribute__((target("avx2")))
+#endif
+#endif
+
+/** String kernels : SSE2 is the x86-64 baseline, AVX2 is selected at runtime, other CPUs use the scalar loops.
+ * Search uses the first / last char filter (see "SIMD-friendly algorithms for substring searching" by Wojciech Mula).
+ */
+
+#ifdef STRING_SSE2
+static bool string_detect_avx2() {
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) return false;
+  __cpuid(info, 1);
+  if ((info[2] & (1 << 27)) == 0) return false;  //OSXSAVE
+  if ((_xgetbv(0) & 6) != 6) return false;  //OS saves YMM registers
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+
+static const bool string_avx2 = string_detect_avx2();
+
+static inline int32 string_ctz(uint32 bits) {
+#if defined(_MSC_VER)
+  unsigned long idx;
+  _BitScanForward(&idx, bits);
+  return (int32)idx;
+#else
+  return __builtin_ctz(bits);
+#endif
+}
+
+static int32 find_char_sse2(const char16* s, int32 len, char16 ch) {
+  __m128i n = _mm_set1_epi16((short)ch);
+  int32 i = 0;
+  for(;i+8<=len;i+=8) {
+    uint32 mask = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_loadu_si128((const __m128i*)(s + i)), n));
+    if (mask != 0) return i + (string_ctz(mask) >> 1);
+  }
+  for(;i<len;i++) {
+    if (s[i] == ch) return i;
+  }
+  return -1;
+}
+
+STRING_AVX2_FUNC static int32 find_char_avx2(const char16* s, int32 len, char16 ch) {
+  __m256i n = _mm256_set1_epi16((short)ch);
+  int32 i = 0;
+  for(;i+16<=len;i+=16) {
+    uint32 mask = _mm256_movemask_epi8(_mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i*)(s + i)), n));
+    if (mask != 0) return i + (string_ctz(mask) >> 1);
+  }
+  for(;i<len;i++) {
+    if (s[i] == ch) return i;
+  }
+  return -1;
+}
+
+//plen >= 2 : compares the first and last char of 8 positions at once, memcmp() only on candidates
+static int32 find_str_sse2(const char16* s, int32 len, const char16* p, int32 plen) {
+  __m128i first = _mm_set1_epi16((short)p[0]);
+  __m128i last = _mm_set1_epi16((short)p[plen - 1]);
+  int32 end = len - plen;  //last start position
+  int32 i = 0;
+  for(;i+8<=end+1;i+=8) {
+    __m128i bf = _mm_loadu_si128((const __m128i*)(s + i));
+    __m128i bl = _mm_loadu_si128((const __m128i*)(s + i + plen - 1));
+    uint32 mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi16(bf, first), _mm_cmpeq_epi16(bl, last)));
+    while (mask != 0) {
+      int32 bit = string_ctz(mask);
+      int32 idx = i + (bit >> 1);
+      if (std::memcmp(s + idx + 1, p + 1, (plen - 2) * sizeof(char16)) == 0) return idx;
+      mask &= ~(3u << bit);
+    }
+  }
+  for(;i<=end;i++) {
+    if (s[i] == p[0] && std::memcmp(s + i + 1, p + 1, (plen - 1) * sizeof(char16)) == 0) return i;
+  }
+  return -1;
+}
+
+STRING_AVX2_FUNC static int32 find_str_avx2(const char16* s, int32 len, const char16* p, int32 plen) {
+  __m256i first = _mm256_set1_epi16((short)p[0]);
+  __m256i last = _mm256_set1_epi16((short)p[plen - 1]);
+  int32 end = len - plen;
+  int32 i = 0;
+  for(;i+16<=end+1;i+=16) {
+    __m256i bf = _mm256_loadu_si256((const __m256i*)(s + i));
+    __m256i bl = _mm256_loadu_si256((const __m256i*)(s + i + plen - 1));
+    uint32 mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi16(bf, first), _mm256_cmpeq_epi16(bl, last)));
+    while (mask != 0) {
+      int32 bit = string_ctz(mask);
+      int32 idx = i + (bit >> 1);
+      if (std::memcmp(s + idx + 1, p + 1, (plen - 2) * sizeof(char16)) == 0) return idx;
+      mask &= ~(3u << bit);
+    }
+  }
+  for(;i<=end;i++) {
+    if (s[i] == p[0] && std::memcmp(s + i + 1, p + 1, (plen - 1) * sizeof(char16)) == 0) return i;
+  }
+  return -1;
+}
+#endif
+
+static int32 find_char(const char16* s, int32 len, char16 ch) {
+#ifdef STRING_SSE2
+  if (string_avx2) return find_char_avx2(s, len, ch);
+  return find_char_sse2(s, len, ch);
+#else
+  for(int32 i=0;i<len;i++) {
+    if (s[i] == ch) return i;
+  }
+  return -1;
+#endif
+}
+
+static int32 find_str(const char16* s, int32 len, const char16* p, int32 plen) {
+  if (plen == 0) return 0;
+  if (plen > len) return -1;
+  if (plen == 1) return find_char(s, len, p[0]);
+#ifdef STRING_SSE2
+  if (string_avx2) return find_str_avx2(s, len, p, plen);
+  return find_str_sse2(s, len, p, plen);
+#else
+  int32 end = len - plen;
+  for(int32 i=0;i<=end;i++) {
+    if (s[i] == p[0] && std::memcmp(s + i + 1, p + 1, (plen - 1) * sizeof(char16)) == 0) return i;
+  }
+  return -1;
+#endif
+}
+
+//length of the ASCII prefix of 16 byte blocks
+static inline int32 utf8_ascii_prefix(const uint8* src, int32 len) {
+  int32 pos = 0;
+#ifdef STRING_SSE2
+  while (pos + 16 <= len && _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(src + pos))) == 0) pos += 16;
+#endif
+  return pos;
+}
+
+//decodes one sequence that starts with a non-ASCII byte, returns U+FFFD for invalid / overlong / truncated sequences
+static inline uint32 utf8_decode(const uint8* src, int32 len, int32& pos) {
+  uint32 c = src[pos++];
+  int32 need;
+  uint32 min;
+  if (c >= 0xc2 && c <= 0xdf) {
+    need = 1;
+    c &= 0x1f;
+    min = 0x80;
+  } else if (c >= 0xe0 && c <= 0xef) {
+    need = 2;
+    c &= 0x0f;
+    min = 0x800;
+  } else if (c >= 0xf0 && c <= 0xf4) {
+    need = 3;
+    c &= 0x07;
+    min = 0x10000;
+  } else {
+    return 0xfffd;
+  }
+  for(int32 a=0;a<need;a++) {
+    if (pos >= len || (src[pos] & 0xc0) != 0x80) return 0xfffd;  //the next byte starts over
+    c = (c << 6) | (src[pos++] & 0x3f);
+  }
+  if (c < min || c > 0x10ffff || (c >= 0xd800 && c <= 0xdfff)) return 0xfffd;
+  return c;
+}
+
 namespace Core {
   System::String* utf8ToString(const char* str) {
     int len = std::strlen(str);
@@ -24,20 +206,286 @@ namespace Core {
     return new System::String(array);
   }
 
-  System::String* addstr(System::String *s1, System::String *s2) {
-    int len1 = s1->$get_Length();
-    int len2 = s2->$get_Length();
-    int len = len1 + len2;
+  $StrPart::$StrPart(System::String* s) : str(s), chars(buf), length(0) {
+    if (s == nullptr) return;  //null is ""
+    chars = s->Value->Array;
+    length = s->Value->Length;
+  }
+
+  $StrPart::$StrPart(System::Object* o) : str(nullptr), chars(buf), length(0) {
+    if (o == nullptr) return;
+    str = o->ToString();
+    if (str == nullptr) return;
+    chars = str->Value->Array;
+    length = str->Value->Length;
+  }
+
+  $StrPart::$StrPart(uint64 v) : str(nullptr) {
+    int32 pos = 32;
+    do {
+      buf[--pos] = (char16)(u'0' + (v % 10));
+      v /= 10;
+    } while (v != 0);
+    chars = buf + pos;
+    length = 32 - pos;
+  }
+
+  $StrPart::$StrPart(int64 v) : $StrPart(v < 0 ? 0 - (uint64)v : (uint64)v) {
+    if (v < 0) {
+      chars--;
+      buf[chars - buf] = u'-';
+      length++;
+    }
+  }
+
+  $StrPart::$StrPart(bool b) : str(nullptr), chars(b ? u"True" : u"False"), length(b ? 4 : 5) {}
+
+  System::String* $concat(const $StrPart* parts, int32 count) {
+    int32 len = 0;
+    for(int32 a=0;a<count;a++) {
+      len += parts[a].length;
+    }
     Core::FixedArray$T<char16> *ca = new (len) Core::FixedArray$T<char16>(&Core::Type_char16);
-    System::Array::Copy$T<char16>(s1->Value, 0, ca, 0, len1);
-    System::Array::Copy$T<char16>(s2->Value, 0, ca, len1, len2);
+    char16* dst = ca->Array;
+    for(int32 a=0;a<count;a++) {
+      std::memcpy(dst, parts[a].chars, parts[a].length * sizeof(char16));
+      dst += parts[a].length;
+    }
     return new System::String(ca);
   }
 
-  //TODO : add other $addstr() functions
+  System::String* addstr(System::String *s1, System::String *s2) {
+    return concat(s1, s2);
+  }
 
   System::String* addstr(System::String *s1, int64 y) {
-    System::String* s2 = System::Int64::ToString(y);
-    return addstr(s1, s2);
+    return concat(s1, y);
+  }
+}
+
+Core::FixedArray$T<char16>* System::String::DecodeUTF8(Core::FixedArray$T<uint8> *utf8) {
+  const uint8* src = utf8->Array;
+  int32 len = utf8->Length;
+  const void* nul = std::memchr(src, 0, len);
+  if (nul != nullptr) len = (int32)((const uint8*)nul - src);
+  //count UTF-16 units
+  int32 units = 0;
+  int32 pos = 0;
+  while (pos < len) {
+    int32 ascii = utf8_ascii_prefix(src + pos, len - pos);
+    pos += ascii;
+    units += ascii;
+    if (pos == len) break;
+    if (src[pos] < 0x80) {
+      pos++;
+      units++;
+    } else {
+      units += utf8_decode(src, len, pos) >= 0x10000 ? 2 : 1;
+    }
+  }
+  Core::FixedArray$T<char16> *chars = new(units) Core::FixedArray$T<char16>(&Core::Type_char16);
+  char16* dst = chars->Array;
+  pos = 0;
+  while (pos < len) {
+#ifdef STRING_SSE2
+    __m128i zero = _mm_setzero_si128();
+    while (pos + 16 <= len) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(src + pos));
+      if (_mm_movemask_epi8(v) != 0) break;
+      _mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi8(v, zero));
+      _mm_storeu_si128((__m128i*)(dst + 8), _mm_unpackhi_epi8(v, zero));
+      pos += 16;
+      dst += 16;
+    }
+    if (pos == len) break;
+#endif
+    if (src[pos] < 0x80) {
+      *dst++ = src[pos++];
+      continue;
+    }
+    uint32 c = utf8_decode(src, len, pos);
+    if (c >= 0x10000) {
+      c -= 0x10000;
+      *dst++ = (char16)(0xd800 + (c >> 10));
+      *dst++ = (char16)(0xdc00 + (c & 0x3ff));
+    } else {
+      *dst++ = (char16)c;
+    }
+  }
+  return chars;
+}
+
+Core::FixedArray$T<uint8>* System::String::ToByteArray() {
+  const char16* src = Value->Array;
+  int32 len = Value->Length;
+  //count bytes
+  int32 bytes = 0;
+  int32 pos = 0;
+  while (pos < len) {
+#ifdef STRING_SSE2
+    __m128i high = _mm_set1_epi16((short)0xff80);
+    while (pos + 8 <= len && _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(_mm_loadu_si128((const __m128i*)(src + pos)), high), _mm_setzero_si128())) == 0xffff) {
+      pos += 8;
+      bytes += 8;
+    }
+    if (pos == len) break;
+#endif
+    char16 ch = src[pos++];
+    if (ch < 0x80) {
+      bytes++;
+    } else if (ch < 0x800) {
+      bytes += 2;
+    } else if (ch >= 0xd800 && ch <= 0xdbff && pos < len && src[pos] >= 0xdc00 && src[pos] <= 0xdfff) {
+      pos++;
+      bytes += 4;
+    } else {
+      bytes += 3;  //includes U+FFFD for an unpaired surrogate
+    }
+  }
+  Core::FixedArray$T<uint8> *array = new(bytes) Core::FixedArray$T<uint8>(&Core::Type_uint8);
+  uint8* dst = array->Array;
+  pos = 0;
+  while (pos < len) {
+#ifdef STRING_SSE2
+    __m128i high = _mm_set1_epi16((short)0xff80);
+    while (pos + 16 <= len) {
+      __m128i v1 = _mm_loadu_si128((const __m128i*)(src + pos));
+      __m128i v2 = _mm_loadu_si128((const __m128i*)(src + pos + 8));
+      __m128i any = _mm_and_si128(_mm_or_si128(v1, v2), high);
+      if (_mm_movemask_epi8(_mm_cmpeq_epi16(any, _mm_setzero_si128())) != 0xffff) break;
+      _mm_storeu_si128((__m128i*)dst, _mm_packus_epi16(v1, v2));
+      pos += 16;
+      dst += 16;
+    }
+    if (pos == len) break;
+#endif
+    uint32 c = src[pos++];
+    if (c < 0x80) {
+      *dst++ = (uint8)c;
+      continue;
+    }
+    if (c < 0x800) {
+      *dst++ = (uint8)(0xc0 | (c >> 6));
+      *dst++ = (uint8)(0x80 | (c & 0x3f));
+      continue;
+    }
+    if (c >= 0xd800 && c <= 0xdfff) {
+      if (c <= 0xdbff && pos < len && src[pos] >= 0xdc00 && src[pos] <= 0xdfff) {
+        c = 0x10000 + ((c - 0xd800) << 10) + (src[pos++] - 0xdc00);
+        *dst++ = (uint8)(0xf0 | (c >> 18));
+        *dst++ = (uint8)(0x80 | ((c >> 12) & 0x3f));
+        *dst++ = (uint8)(0x80 | ((c >> 6) & 0x3f));
+        *dst++ = (uint8)(0x80 | (c & 0x3f));
+        continue;
+      }
+      c = 0xfffd;
+    }
+    *dst++ = (uint8)(0xe0 | (c >> 12));
+    *dst++ = (uint8)(0x80 | ((c >> 6) & 0x3f));
+    *dst++ = (uint8)(0x80 | (c & 0x3f));
+  }
+  return array;
+}
+
+//offset / length are clamped to the string (length -1 = to the end)
+static bool string_range(int32 size, int32 &offset, int32 &length) {
+  if (offset < 0) offset = 0;
+  if (offset >= size) return false;
+  if (length == -1 || offset + length > size) length = size - offset;
+  return length > 0;
+}
+
+int32 System::String::IndexOf(System::String *str, int32 offset, int32 length) {
+  if (!string_range(Value->Length, offset, length)) return -1;
+  int32 idx = find_str(Value->Array + offset, length, str->Value->Array, str->Value->Length);
+  return idx == -1 ? -1 : offset + idx;
+}
+
+int32 System::String::IndexOf(char16 ch, int32 offset, int32 length) {
+  if (!string_range(Value->Length, offset, length)) return -1;
+  int32 idx = find_char(Value->Array + offset, length, ch);
+  return idx == -1 ? -1 : offset + idx;
+}
+
+bool System::String::Equals(System::String *other) {
+  if (other == this) return true;
+  if (other == nullptr) return false;
+  int32 len = Value->Length;
+  if (other->Value->Length != len) return false;
+  //libc memcmp() is already vectorized and selects AVX2 / AVX-512 at runtime
+  return std::memcmp(Value->Array, other->Value->Array, len * sizeof(char16)) == 0;
+}
+
+//intern table : open addressing on a GC array (static root), resized at 1/2 load
+static Core::FixedArray$T<System::String*> *intern_table;
+static int32 intern_count;
+static std::mutex intern_mutex;
+
+struct InternLock {
+  InternLock() {
+    Core::$GCNative native;  //a collection may run while this thread waits
+    intern_mutex.lock();
+  }
+  ~InternLock() {
+    intern_mutex.unlock();
+  }
+};
+
+static int32 intern_find(Core::FixedArray$T<System::String*> *table, System::String *str) {
+  int32 mask = table->Length - 1;
+  int32 idx = str->GetHashCode() & mask;
+  while (true) {
+    System::String *s = table->Array[idx];
+    if (s == nullptr || s->Equals(str)) return idx;
+    idx = (idx + 1) & mask;
+  }
+}
+
+static System::String* intern_locked(System::String *str, bool add) {
+  if (intern_table == nullptr) {
+    if (!add) return nullptr;
+    Core::Object::GC_add_static_ref((Core::Object**)&intern_table);
+    intern_table = new(1024) Core::FixedArray$T<System::String*>(System::String::$GetType());
+  }
+  int32 idx = intern_find(intern_table, str);
+  System::String *s = intern_table->Array[idx];
+  if (s != nullptr || !add) return s;
+  if ((intern_count + 1) * 2 > intern_table->Length) {
+    Core::FixedArray$T<System::String*> *table = new(intern_table->Length * 2) Core::FixedArray$T<System::String*>(System::String::$GetType());
+    for(int32 a=0;a<intern_table->Length;a++) {
+      System::String *e = intern_table->Array[a];
+      if (e != nullptr) Core::$wb(&table->Array[intern_find(table, e)], e);
+    }
+    intern_table = table;
+    idx = intern_find(intern_table, str);
+  }
+  Core::$wb(&intern_table->Array[idx], str);
+  intern_count++;
+  return str;
+}
+
+System::String* System::String::Intern(System::String *str) {
+  if (str == nullptr) return nullptr;
+  InternLock lock;
+  return intern_locked(str, true);
+}
+
+System::String* System::String::IsInterned(System::String *str) {
+  if (str == nullptr) return nullptr;
+  InternLock lock;
+  return intern_locked(str, false);
+}
+
+System::String* Core::$literal(System::String **slot, const char16_t *text) {
+  System::String *str = Core::$atomic(slot)->load(std::memory_order_acquire);
+  if (str != nullptr) return str;
+  System::String *created = Core::utf16ToString(text);
+  InternLock lock;
+  str = *slot;
+  if (str == nullptr) {
+    Core::Object::GC_add_static_ref((Core::Object**)slot);
+    str = intern_locked(created, true);
+    Core::$atomic(slot)->store(str, std::memory_order_release);
   }
+  return str;
 }
@@ -1,6 +1,7 @@
 namespace System {
-  public class String {
+  public sealed class String {
     private char[] Value;
+    private int Hash;  //cached GetHashCode() (0 = not computed yet)
     public int Length {
       get {return Value.Length;}
     }
@@ -35,114 +36,15 @@ namespace System {
       Value = new char[len];
       Array.Copy<char>(chars, offset, Value, 0, len);
     }
+    /** Decodes UTF-8 (up to the first NUL byte), invalid sequences become U+FFFD. */
     public String(byte[] utf8) {
-      /**
-        UTF8 Format:
-          1st bytes:
-            0xxxxxxx = 7bit (1 byte)
-            110xxxxx = 5bit (2 byte) 11bit total (import supported) (not exported)
-            1110xxxx = 4bit (3 byte) 16bit total (import/export supported)
-            11110xxx = 3bit (4 byte) 21bit total (import truncated to 16bit) (not exported)
-          2nd,3rd,4th bytes only:
-            10xxxxxx = 6bit
-      */
-      //calc # utf8 codes from utf8
-      int pos = 0;
-      int length = 0;
-      for(int a=0;a<utf8.Length;a++) {
-        byte ch = utf8[a];
-        if (ch == 0) break;
-        if (ch > 127) {
-          length++;
-          if ((ch & 0b11110000) == 0b11110000) {
-            //21 bit - 4 bytes - not supported (truncate to 16bit)
-            a += 3;
-          } else if ((ch & 0b11100000) == 0b11100000) {
-            //16 bit - 3 bytes
-            a += 2;
-          } else if ((ch & 0b11000000) == 0b11000000) {
-            //11 bit - 2 bytes
-            a++;
-          } else {
-            //bad utf8 code (just output 6 bit code)
-          }
-        } else {
-          length++;
-        }
-      }
-
-      //convert codes
-      Value = new char[length];
-      for(int a=0;a<length;a++) {
-        int ch = utf8[pos++];
-        if (ch == 0) break;
-        int bits;
-        int bits32;
-        if (ch > 127) {
-          if ((ch & 0b11110000) == 0b11110000) {
-            //21 bit - 4 bytes - not supported (truncate to 16bit)
-            if (a+3 > length) break;
-            //3 6 6 6 = 21 bits
-            bits32 = (ch & 0b00000111) << 18;
-            ch = utf8[pos++];
-            bits32 |= (ch & 0b00111111) << 12;
-            ch = utf8[pos++];
-            bits32 |= (ch & 0b00111111) << 6;
-            ch = utf8[pos++];
-            bits32 |= (ch & 0b00111111);
-            ch = (bits32 & 0xffff);  //bits lost
-          } else if ((ch & 0b11100000) == 0b11100000) {
-            //16 bit - 3 bytes
-            if (a+2 > length) break;
-            //4 6 6
-            bits = (ch & 0b00001111) << 12;
-            ch = utf8[pos++];
-            bits |= (ch & 0b00111111) << 6;
-            ch = utf8[pos++];
-            bits |= (ch & 0b00111111);
-            ch = bits;
-          } else if ((ch & 0b11000000) == 0b11000000) {
-            //11 bit - 2 bytes
-            if (a+1 > length) break;
-            //5 6
-            bits = (ch & 0b00011111) << 6;
-            ch = utf8[pos++];
-            bits |= (ch & 0b00111111);
-            ch = bits;
-          } else {
-            //bad utf8 code (just output 6 bit code)
-            ch &= 0b00111111;
-          }
-        }
-        Value[a] = (char)ch;
-      }
+      Value = DecodeUTF8(utf8);
     }
-    public byte[] ToByteArray() {
-      //calc # utf8 bytes from utf16
-      int length = Value.Length;
-      int bytes = length;
-      for(int a=0;a<length;a++) {
-        if (Value[a] > 127) bytes += 2;
-      }
-      bytes++;  //null terminate string
-      byte[] copy = new byte[bytes];
-      //convert codes
-      int pos = 0;
-      for(int a=0;a<length;a++) {
-        char ch = Value[a];
-        if (ch > 127) {
-          //3 byte format (16 bit)
-          //1110xxxx = 4bit (3 byte) 16bit total
-          //10xxxxxx = 6bit
-          //10xxxxxx = 6bit
-          copy[pos++] = (byte)(0b1110000 + (ch >> 12));
-          copy[pos++] = (byte)(0b1000000 + ((ch >> 6) & 0b00111111));
-          copy[pos++] = (byte)(0b1000000 + (ch & 0b00111111));
-        } else {
-          copy[pos++] = (byte)ch;
-        }
-      }
-      return copy;
+    private static extern char[] DecodeUTF8(byte[] utf8);
+    /** Encodes to UTF-8 (no NUL terminator), unpaired surrogates become U+FFFD. */
+    public extern byte[] ToByteArray();
+    public char CharAt(int index) {
+      return Value[index];
     }
     public char[] ToCharArray() {
       int length = Length;
@@ -150,6 +52,10 @@ namespace System {
       Array.Copy<char>(Value, 0, copy, 0, length);
       return copy;
     }
+    /** Copies count chars from offset into dst at dstOffset. */
+    public void CopyTo(int offset, char[] dst, int dstOffset, int count) {
+      Array.Copy<char>(Value, offset, dst, dstOffset, count);
+    }
     public String Substring(int offset, int length = -1) {
       if (length == -1) {
         length = Value.Length - offset;
@@ -159,34 +65,9 @@ namespace System {
       }
       return new String(this, offset, length);
     }
-    public int IndexOf(String str, int offset = 0, int length = -1) {
-      int thisLength = length == -1 ? Value.Length - offset : length;
-      if (thisLength <= 0) return -1;
-      int strLength = str.Value.Length;
-      if (strLength > thisLength) return -1;
-      char[] cmp = str.Value;
-      int end = thisLength - strLength + offset;
-      for(int i=offset;i<end;i++) {
-        bool match = true;
-        for(int len=0;len<strLength;len++) {
-          if (Value[i+len] != cmp[len]) {
-            match = false;
-            break;
-          }
-        }
-        if (match) return i;
-      }
-      return -1;
-    }
-    public int IndexOf(char ch, int offset = 0, int length = -1) {
-      int thisLength = length == -1 ? Value.Length - offset : length;
-      if (thisLength <= 0) return -1;
-      int end = offset + thisLength;
-      for(int i=offset;i<end;i++) {
-        if (Value[i] == ch) return i;
-      }
-      return -1;
-    }
+    //IndexOf() / Equals() are SSE2 / AVX2 kernels in String.cpp
+    public extern int IndexOf(String str, int offset = 0, int length = -1);
+    public extern int IndexOf(char ch, int offset = 0, int length = -1);
     public String[] Split(String token) {
       String[] strs;
       int thisLength = Length;
@@ -229,21 +110,60 @@ namespace System {
       int offset = 0;
       for(int i=0;i<parts.Length;i++) {
         Array.Copy<char>(parts[i].Value, 0, tmp, offset, parts[i].Value.Length);
+        offset += parts[i].Value.Length;
       }
       return new String(tmp);
     }
-    public bool Equals(String other) {
-      int length = Value.Length;
-      if (other.Value.Length != length) return false;
-      char[] s1 = Value;
-      char[] s2 = other.Value;
-      for(int i=0;i<length;i++) {
-        if (s1[i] != s2[i]) return false;
+    public extern bool Equals(String other);
+    /** Returns the one shared instance of the text of str (adds str if the text is new).
+     * String literals are interned, so equal literals are the same object and Equals() returns on the pointer compare.
+     */
+    public static extern String Intern(String str);
+    /** Returns the interned instance of the text of str or null. */
+    public static extern String IsInterned(String str);
+    public override bool Equals(Object obj) {
+      String other = obj as String;
+      if (other == null) return false;
+      return Equals(other);
+    }
+    public override int GetHashCode() {
+      int hash = Hash;
+      if (hash == 0) {
+        char[] chars = Value;
+        int length = chars.Length;
+        for(int i=0;i<length;i++) {
+          hash = hash * 31 + chars[i];
+        }
+        Hash = hash;  //strings are immutable : computed once (threads racing store the same value)
       }
-      return true;
+      return hash;
     }
     public bool Contains(String str) {
       return IndexOf(str) != -1;
     }
+    /** foreach over a String is compiled to an indexed loop over its chars (GetEnumerator() is not called). */
+    public CharEnumerator GetEnumerator() {
+      return new CharEnumerator(this);
+    }
+  }
+
+  public class CharEnumerator {
+    public CharEnumerator(String str) {this.str = str;}
+    private readonly String str;
+    private int idx = -1;
+    public bool MoveNext() {
+      if (idx >= str.Length) return false;
+      idx++;
+      return idx < str.Length;
+    }
+    public char Current {
+      get {
+        if (idx < 0 || idx >= str.Length) return (char)0;
+        return str.CharAt(idx);
+      }
+    }
+    public void Reset() {
+      idx = -1;
+    }
   }
 }
@@ -0,0 +1,112 @@
+namespace System.Text {
+  /** Mutable string : appends go into one char buffer that doubles when full (amortized O(1)),
+   * numbers are formatted directly into the buffer.
+   * ToString() allocates the result once.
+   */
+  public class StringBuilder {
+    private char[] Chars;
+    private int Count;
+    private static int MinCapacity = 16;
+    public StringBuilder(int capacity = 16) {
+      if (capacity < 0) capacity = 0;
+      Chars = new char[capacity];
+    }
+    public StringBuilder(String str) {
+      int len = str == null ? 0 : str.Length;
+      Chars = new char[len < MinCapacity ? MinCapacity : len];
+      Append(str);
+    }
+    public int Length {
+      get {return Count;}
+    }
+    public int Capacity() {
+      return Chars.Length;
+    }
+    /** Makes room for at least capacity chars (with one allocation). */
+    public void EnsureCapacity(int capacity) {
+      if (capacity <= Chars.Length) return;
+      int size = Chars.Length * 2;
+      if (size < MinCapacity) size = MinCapacity;
+      if (size < capacity) size = capacity;
+      char[] NewChars = new char[size];
+      Array.Copy<char>(Chars, 0, NewChars, 0, Count);
+      Chars = NewChars;
+    }
+    public StringBuilder Append(String str) {
+      if (str == null) return this;
+      int len = str.Length;
+      EnsureCapacity(Count + len);
+      str.CopyTo(0, Chars, Count, len);
+      Count += len;
+      return this;
+    }
+    public StringBuilder Append(String str, int offset, int length) {
+      if (str == null) return this;
+      EnsureCapacity(Count + length);
+      str.CopyTo(offset, Chars, Count, length);
+      Count += length;
+      return this;
+    }
+    public StringBuilder Append(char ch) {
+      if (Count == Chars.Length) EnsureCapacity(Count + 1);
+      Chars[Count++] = ch;
+      return this;
+    }
+    public StringBuilder Append(char[] chars, int offset, int length) {
+      EnsureCapacity(Count + length);
+      Array.Copy<char>(chars, offset, Chars, Count, length);
+      Count += length;
+      return this;
+    }
+    public StringBuilder Append(int value) {
+      return Append((long)value);
+    }
+    public StringBuilder Append(long value) {
+      //count digits first then write them backwards in place
+      ulong mag = value < 0 ? (ulong)0 - (ulong)value : (ulong)value;
+      int digits = 1;
+      for(ulong t=mag;t>=10;t/=10) {
+        digits++;
+      }
+      int len = value < 0 ? digits + 1 : digits;
+      EnsureCapacity(Count + len);
+      int pos = Count + len;
+      do {
+        Chars[--pos] = (char)('0' + (int)(mag % 10));
+        mag /= 10;
+      } while (mag != 0);
+      if (value < 0) Chars[Count] = '-';
+      Count += len;
+      return this;
+    }
+    public StringBuilder Append(bool value) {
+      return Append(value ? "True" : "False");
+    }
+    public StringBuilder Append(Object obj) {
+      if (obj == null) return this;
+      return Append(obj.ToString());
+    }
+    public StringBuilder AppendLine(String str = null) {
+      Append(str);
+      return Append('\n');
+    }
+    public char CharAt(int idx) {
+      return Chars[idx];
+    }
+    public void SetLength(int length) {
+      if (length < 0) length = 0;
+      EnsureCapacity(length);
+      for(int i=Count;i<length;i++) {
+        Chars[i] = (char)0;
+      }
+      Count = length;
+    }
+    public StringBuilder Clear() {
+      Count = 0;
+      return this;
+    }
+    public override String ToString() {
+      return new String(Chars, 0, Count);
+    }
+  }
+}
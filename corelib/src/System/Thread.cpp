@@ -28,6 +28,7 @@ void System::Thread::Create() {
 void System::Thread::Join() {
   std::thread *std_thread = (std::thread*)StdThread;
   if (std_thread != nullptr) {
+    Core::$GCNative native;
     std_thread->join();
   }
 }
@@ -42,3 +43,7 @@ void System::Thread::Destroy() {
 System::Thread* System::Thread::Current() {
   return current_thread;
 }
+
+void System::Thread::Yield() {
+  std::this_thread::yield();
+}
@@ -9,6 +9,7 @@ namespace System {
       Destroy();
     }
     public extern static Thread Current();
+    public extern static void Yield();  //gives up the rest of the time slice
 
     private extern void GC_add_thread();
     private extern void GC_delete_thread();
@@ -20,6 +21,7 @@ namespace System {
     private unsafe void* NativeHandle;
     private unsafe void* StackStart;
     private unsafe void* StackCurrent;
+    private unsafe void* GCState;  //safepoint state (see Object.cpp)
     private extern void Create();
     private extern void Destroy();
   }
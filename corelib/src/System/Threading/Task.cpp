@@ -0,0 +1,18 @@
+#include <atomic>
+
+//the fences pair AddWaiter() with Execute() : either the waiter sees the task completed or Execute() sees the waiter
+
+void System::Threading::Task::AddWaiter() {
+  Core::$atomic(&Waiters)->fetch_add(1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+bool System::Threading::Task::CasContinuations(System::Threading::Task *expected, System::Threading::Task *value) {
+  return Core::$cas(&Continuations, expected, value);
+}
+
+System::Threading::Task* System::Threading::Task::ExchangeContinuations(System::Threading::Task *value) {
+  System::Threading::Task *old = Core::$xchg(&Continuations, value);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  return old;
+}
@@ -0,0 +1,73 @@
+using System;
+
+namespace System.Threading {
+  /** Unit of work run by a ThreadPool.
+   * Override Run() (like Thread) and call Start() to run it on the default pool.
+   * Wait() inside a pool worker runs other tasks until this one is done (fork-join).
+   */
+  public class Task {
+    public virtual void Run() {}
+
+    /** Runs the task on the default pool. */
+    public void Start() {
+      ThreadPool.GetDefault().Submit(this);
+    }
+
+    public bool IsCompleted() {
+      return Continuations == this;
+    }
+
+    /** Waits until the task is done and throws the exception Run() threw (if any). */
+    public void Wait() {
+      if (!IsCompleted()) {
+        if (Pool == null) throw new Exception("Task not started");
+        Pool.WaitFor(this);
+      }
+      if (Error != null) throw Error;
+    }
+
+    /** Starts next when this task is done (at once if it is already done). */
+    public void ContinueWith(Task next) {
+      while (true) {
+        Task head = Continuations;
+        if (head == this) {
+          Pool.Submit(next);
+          return;
+        }
+        next.NextContinuation = head;
+        if (CasContinuations(head, next)) return;
+      }
+    }
+
+    public Exception GetException() {
+      return Error;
+    }
+
+    internal ThreadPool Pool;
+    internal Task Next;  //ThreadPool shared queue
+    private Task Continuations;  //pending continuations (linked by NextContinuation), this = completed
+    private Task NextContinuation;
+    private Exception Error;
+    private int Waiters;  //threads blocked in ThreadPool.WaitFor()
+
+    internal void Execute() {
+      try {
+        Run();
+      } catch (Exception e) {
+        Error = e;
+      }
+      Task list = ExchangeContinuations(this);
+      while (list != null) {
+        Task next = list.NextContinuation;
+        list.NextContinuation = null;
+        Pool.Submit(list);
+        list = next;
+      }
+      if (Waiters > 0) Pool.WakeWaiters();
+    }
+
+    internal extern void AddWaiter();
+    private extern bool CasContinuations(Task expected, Task value);
+    private extern Task ExchangeContinuations(Task value);
+  }
+}
@@ -0,0 +1,106 @@
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+/** Idle workers (event count) : a worker announces itself (PrepareWait), looks for work again and then sleeps (CommitWait)
+ * unless Notify() bumped the epoch in between.  Notify() only takes the lock when someone is sleeping.
+ */
+struct ThreadPoolPark {
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::atomic<int> sleepers;
+  std::atomic<uint32> epoch;
+};
+
+//pool and queue of the current worker (the pool keeps both reachable)
+thread_local System::Threading::ThreadPool *current_pool;
+thread_local System::Threading::WorkQueue *current_queue;
+
+void System::Threading::ThreadPool::Create() {
+  ThreadPoolPark *park = new ThreadPoolPark();
+  park->sleepers = 0;
+  park->epoch = 0;
+  NativePark = (void*)park;
+}
+
+void System::Threading::ThreadPool::Destroy() {
+  delete (ThreadPoolPark*)NativePark;
+}
+
+int System::Threading::ThreadPool::GetProcessorCount() {
+  int count = std::thread::hardware_concurrency();
+  if (count <= 0) count = 1;
+  return count;
+}
+
+void System::Threading::ThreadPool::SetCurrent(System::Threading::ThreadPool *pool, System::Threading::WorkQueue *queue) {
+  current_pool = pool;
+  current_queue = queue;
+}
+
+System::Threading::ThreadPool* System::Threading::ThreadPool::CurrentPool() {
+  return current_pool;
+}
+
+System::Threading::WorkQueue* System::Threading::ThreadPool::CurrentQueue() {
+  return current_queue;
+}
+
+//Default is read without DefaultLock : acquire pairs with the release in StoreDefault()
+System::Threading::ThreadPool* System::Threading::ThreadPool::LoadDefault() {
+  return Core::$atomic(&Default)->load(std::memory_order_acquire);
+}
+
+void System::Threading::ThreadPool::StoreDefault(System::Threading::ThreadPool *pool) {
+  Core::$atomic(&Default)->store(pool, std::memory_order_release);
+}
+
+//task.Pool : null -> this, fails if another Submit() got there first
+bool System::Threading::ThreadPool::ClaimTask(System::Threading::Task *task) {
+  return Core::$cas(&task->Pool, (System::Threading::ThreadPool*)nullptr, this);
+}
+
+int System::Threading::ThreadPool::PrepareWait() {
+  ThreadPoolPark *park = (ThreadPoolPark*)NativePark;
+  park->sleepers.fetch_add(1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  return (int)park->epoch.load();
+}
+
+void System::Threading::ThreadPool::CancelWait() {
+  ThreadPoolPark *park = (ThreadPoolPark*)NativePark;
+  park->sleepers.fetch_sub(1);
+}
+
+void System::Threading::ThreadPool::CommitWait(int key) {
+  ThreadPoolPark *park = (ThreadPoolPark*)NativePark;
+  {
+    Core::$GCNative native;
+    std::unique_lock<std::mutex> lock(park->mutex);
+    while (park->epoch.load() == (uint32)key) {
+      park->condition.wait(lock);
+    }
+  }
+  park->sleepers.fetch_sub(1);
+}
+
+void System::Threading::ThreadPool::Notify() {
+  ThreadPoolPark *park = (ThreadPoolPark*)NativePark;
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (park->sleepers.load(std::memory_order_relaxed) == 0) return;
+  {
+    std::lock_guard<std::mutex> lock(park->mutex);
+    park->epoch.fetch_add(1);
+  }
+  park->condition.notify_one();
+}
+
+void System::Threading::ThreadPool::NotifyAll() {
+  ThreadPoolPark *park = (ThreadPoolPark*)NativePark;
+  {
+    std::lock_guard<std::mutex> lock(park->mutex);
+    park->epoch.fetch_add(1);
+  }
+  park->condition.notify_all();
+}
@@ -0,0 +1,196 @@
+using System;
+
+namespace System.Threading {
+  /** Fixed set of worker threads running Tasks.
+   * Workers are started (and registered with the GC) once instead of one Thread per task.
+   * Each worker owns a WorkQueue : tasks started by a worker are pushed to its own queue and idle workers steal from the others.
+   * Tasks started by other threads (or when a WorkQueue is full) go to a shared queue.
+   */
+  public class ThreadPool {
+    private class Worker : Thread {
+      public ThreadPool Pool;
+      public WorkQueue Queue;
+      public int Index;
+      public override void Run() {
+        Pool.WorkerLoop(this);
+      }
+    }
+
+    private static ThreadPool Default;
+    private static Mutex DefaultLock = new Mutex();
+
+    private Worker[] Workers;
+    private Mutex SharedLock;
+    private Task SharedHead;
+    private Task SharedTail;
+    private Mutex WaitLock;
+    private bool Stopped;
+    private unsafe void* NativePark;  //idle workers (see ThreadPool.cpp)
+
+    /** Creates a pool with count workers (0 = one per processor). */
+    public ThreadPool(int count) {
+      if (count <= 0) count = GetProcessorCount();
+      Create();
+      SharedLock = new Mutex();
+      WaitLock = new Mutex();
+      Workers = new Worker[count];
+      for(int a=0;a<count;a++) {
+        Worker worker = new Worker();
+        worker.Pool = this;
+        worker.Queue = new WorkQueue();
+        worker.Index = a;
+        Workers[a] = worker;
+      }
+      for(int a=0;a<count;a++) {
+        Workers[a].Start();
+      }
+    }
+    ~ThreadPool() {
+      Destroy();
+    }
+
+    /** Pool used by Task.Start() (created on first use). */
+    public static ThreadPool GetDefault() {
+      ThreadPool pool = LoadDefault();
+      if (pool == null) {
+        DefaultLock.Lock();
+        pool = Default;
+        if (pool == null) {
+          pool = new ThreadPool(0);
+          StoreDefault(pool);  //published after the constructor's writes
+        }
+        DefaultLock.Unlock();
+      }
+      return pool;
+    }
+
+    public int GetThreadCount() {
+      return Workers.Length;
+    }
+
+    public void Submit(Task task) {
+      if (Stopped) throw new Exception("ThreadPool is shutdown");
+      if (!ClaimTask(task)) throw new Exception("Task already started");
+      WorkQueue queue = CurrentQueue();
+      if (queue == null || CurrentPool() != this || !queue.Push(task)) {
+        SharedLock.Lock();
+        if (SharedTail == null) {
+          SharedHead = task;
+        } else {
+          SharedTail.Next = task;
+        }
+        SharedTail = task;
+        SharedLock.Unlock();
+      }
+      Notify();
+    }
+
+    /** Stops the workers once all queued tasks are done and waits for them. */
+    public void Shutdown() {
+      Stopped = true;
+      NotifyAll();
+      for(int a=0;a<Workers.Length;a++) {
+        Workers[a].Join();
+      }
+    }
+
+    private void WorkerLoop(Worker worker) {
+      WorkQueue queue = worker.Queue;
+      SetCurrent(this, queue);
+      int victim = worker.Index;
+      while (true) {
+        Task task = queue.Pop();
+        if (task == null) task = FindWork(queue, victim++);
+        if (task != null) {
+          task.Execute();
+          continue;
+        }
+        //announce sleep then look again so a Submit() in between is not missed
+        int key = PrepareWait();
+        task = FindWork(queue, victim++);
+        if (task != null) {
+          CancelWait();
+          task.Execute();
+          continue;
+        }
+        if (Stopped) {
+          CancelWait();
+          break;
+        }
+        CommitWait(key);
+      }
+      SetCurrent(null, null);
+    }
+
+    private Task FindWork(WorkQueue queue, int victim) {
+      Task task = TakeShared();
+      if (task != null) return task;
+      int count = Workers.Length;
+      for(int a=0;a<count;a++) {
+        WorkQueue other = Workers[(victim + a) % count].Queue;
+        if (other == queue) continue;
+        task = other.Steal();
+        if (task != null) return task;
+      }
+      return null;
+    }
+
+    private Task TakeShared() {
+      if (SharedHead == null) return null;
+      SharedLock.Lock();
+      Task task = SharedHead;
+      if (task != null) {
+        SharedHead = task.Next;
+        if (SharedHead == null) SharedTail = null;
+        task.Next = null;
+      }
+      SharedLock.Unlock();
+      return task;
+    }
+
+    /** Waits for a task : workers of this pool run other tasks meanwhile, other threads block. */
+    internal void WaitFor(Task task) {
+      WorkQueue queue = CurrentQueue();
+      if (queue != null && CurrentPool() == this) {
+        int victim = 0;
+        while (!task.IsCompleted()) {
+          Task other = queue.Pop();
+          if (other == null) other = FindWork(queue, victim++);
+          if (other != null) {
+            other.Execute();
+          } else {
+            Thread.Yield();  //task is running on another worker
+          }
+        }
+        return;
+      }
+      WaitLock.Lock();
+      task.AddWaiter();
+      while (!task.IsCompleted()) {
+        WaitLock.Wait();
+      }
+      WaitLock.Unlock();
+    }
+
+    internal void WakeWaiters() {
+      WaitLock.Lock();
+      WaitLock.NotifyAll();
+      WaitLock.Unlock();
+    }
+
+    public extern static int GetProcessorCount();
+    private extern static void SetCurrent(ThreadPool pool, WorkQueue queue);
+    private extern static ThreadPool CurrentPool();
+    private extern static WorkQueue CurrentQueue();
+    private extern static ThreadPool LoadDefault();
+    private extern static void StoreDefault(ThreadPool pool);
+    private extern bool ClaimTask(Task task);
+    private extern int PrepareWait();
+    private extern void CancelWait();
+    private extern void CommitWait(int key);
+    private extern void Notify();
+    private extern void NotifyAll();
+    private extern void Create();
+    private extern void Destroy();
+  }
+}
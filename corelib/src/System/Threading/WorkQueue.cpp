@@ -0,0 +1,82 @@
+#include <atomic>
+
+/** Chase-Lev deque indexes with the memory orders from "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al).
+ * The ring does not grow : the pool puts tasks in its shared queue when Push() fails.
+ * top and bottom are on separate cache lines (thieves only write top).
+ */
+struct WorkQueueIndex {
+  alignas(64) std::atomic<int64> top;
+  alignas(64) std::atomic<int64> bottom;
+};
+
+void System::Threading::WorkQueue::Create() {
+  WorkQueueIndex *index = new WorkQueueIndex();
+  index->top = 0;
+  index->bottom = 0;
+  NativeQueue = (void*)index;
+}
+
+void System::Threading::WorkQueue::Destroy() {
+  delete (WorkQueueIndex*)NativeQueue;
+}
+
+bool System::Threading::WorkQueue::Push(System::Threading::Task *task) {
+  WorkQueueIndex *index = (WorkQueueIndex*)NativeQueue;
+  int64 b = index->bottom.load(std::memory_order_relaxed);
+  int64 t = index->top.load(std::memory_order_acquire);
+  int size = Buffer->Length;
+  if (b - t >= size) return false;
+  Core::$wb(&Buffer->Array[b & (size - 1)], task);
+  std::atomic_thread_fence(std::memory_order_release);
+  index->bottom.store(b + 1, std::memory_order_relaxed);
+  return true;
+}
+
+System::Threading::Task* System::Threading::WorkQueue::Pop() {
+  WorkQueueIndex *index = (WorkQueueIndex*)NativeQueue;
+  int64 b = index->bottom.load(std::memory_order_relaxed) - 1;
+  index->bottom.store(b, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int64 t = index->top.load(std::memory_order_relaxed);
+  if (t > b) {
+    index->bottom.store(b + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  System::Threading::Task **slot = &Buffer->Array[b & (Buffer->Length - 1)];
+  System::Threading::Task *task = *slot;
+  if (t == b) {
+    //last task : race with thieves
+    if (!index->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      task = nullptr;
+    }
+    index->bottom.store(b + 1, std::memory_order_relaxed);
+  }
+  //drop the reference so the ring does not keep finished tasks alive (a losing owner leaves it to the thief)
+  if (task != nullptr) Core::$atomic(slot)->store(nullptr, std::memory_order_relaxed);
+  return task;
+}
+
+System::Threading::Task* System::Threading::WorkQueue::Steal() {
+  WorkQueueIndex *index = (WorkQueueIndex*)NativeQueue;
+  while (true) {
+    int64 t = index->top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64 b = index->bottom.load(std::memory_order_acquire);
+    if (t >= b) return nullptr;
+    System::Threading::Task **slot = &Buffer->Array[t & (Buffer->Length - 1)];
+    System::Threading::Task *task = Core::$atomic(slot)->load(std::memory_order_relaxed);
+    if (index->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      //clear the slot unless the owner already reused it for a new Push()
+      System::Threading::Task *expected = task;
+      Core::$atomic(slot)->compare_exchange_strong(expected, nullptr, std::memory_order_relaxed);
+      return task;
+    }
+    //lost the race with another thief (or the owner) : retry so a non-empty queue never looks empty
+  }
+}
+
+int System::Threading::WorkQueue::Size() {
+  WorkQueueIndex *index = (WorkQueueIndex*)NativeQueue;
+  int64 size = index->bottom.load(std::memory_order_relaxed) - index->top.load(std::memory_order_relaxed);
+  return size < 0 ? 0 : (int)size;
+}
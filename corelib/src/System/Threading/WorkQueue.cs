@@ -0,0 +1,25 @@
+using System;
+
+namespace System.Threading {
+  /** Chase-Lev work stealing deque of Tasks (fixed capacity ring, see WorkQueue.cpp).
+   * The owner thread pushes and pops at the bottom (LIFO), other threads steal from the top (FIFO).
+   */
+  public class WorkQueue {
+    public WorkQueue() {
+      Buffer = new Task[4096];  //must be a power of 2
+      Create();
+    }
+    ~WorkQueue() {
+      Destroy();
+    }
+    public extern bool Push(Task task);  //owner only : returns false when full
+    public extern Task Pop();  //owner only : returns null when empty
+    public extern Task Steal();  //any thread : returns null when empty
+    public extern int Size();  //approximate
+
+    private Task[] Buffer;
+    private unsafe void* NativeQueue;  //top / bottom indexes
+    private extern void Create();
+    private extern void Destroy();
+  }
+}
@@ -0,0 +1,57 @@
+using System;
+
+/** Array<T> benchmark (based on example2) : appends with geometric growth, Reserve(), foreach (indexed loop) and Insert/RemoveAt (memmove). */
+
+public class Example {
+  public static int Count = 1024 * 1024;
+  public static int Main(String[] args) {
+    String s1 = "--";
+    String s2 = "++";
+
+    long start = DateTime.CurrentTimeEpoch();
+    long bytes = GC.GetAllocatedBytesForCurrentThread();
+    Array<String> al = new Array<String>();
+    for(int x=0;x<Count;x++) {
+      al.Add(s1);
+    }
+    long stop = DateTime.CurrentTimeEpoch();
+    Console.Out.WriteLine("add=" + (stop - start) + "ms allocated=" + (GC.GetAllocatedBytesForCurrentThread() - bytes) + " capacity=" + al.Capacity());
+
+    start = DateTime.CurrentTimeEpoch();
+    bytes = GC.GetAllocatedBytesForCurrentThread();
+    Array<String> reserved = new Array<String>();
+    reserved.Reserve(Count);
+    for(int x=0;x<Count;x++) {
+      reserved.Add(s1);
+    }
+    stop = DateTime.CurrentTimeEpoch();
+    Console.Out.WriteLine("reserve+add=" + (stop - start) + "ms allocated=" + (GC.GetAllocatedBytesForCurrentThread() - bytes));
+
+    start = DateTime.CurrentTimeEpoch();
+    bytes = GC.GetAllocatedBytesForCurrentThread();
+    int found = 0;
+    for(int pass=0;pass<16;pass++) {
+      foreach(String e in al) {
+        if (e == s2) found++;
+      }
+    }
+    stop = DateTime.CurrentTimeEpoch();
+    Console.Out.WriteLine("foreach=" + (stop - start) + "ms allocated=" + (GC.GetAllocatedBytesForCurrentThread() - bytes) + " found=" + found);
+
+    start = DateTime.CurrentTimeEpoch();
+    Array<String> small = new Array<String>();
+    for(int x=0;x<32768;x++) {
+      small.Insert(0, s1);
+    }
+    while (small.Size() > 0) {
+      small.RemoveAt(0);
+    }
+    stop = DateTime.CurrentTimeEpoch();
+    Console.Out.WriteLine("insert+remove=" + (stop - start) + "ms");
+
+    al.Clear();
+    al.TrimExcess();
+    Console.Out.WriteLine("trimmed capacity=" + al.Capacity());
+    return 0;
+  }
+}
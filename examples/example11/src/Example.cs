@@ -0,0 +1,42 @@
+using System;
+using System.Text;
+
+/** String building benchmark : a + b + c ... chains (one Core::concat call each) and StringBuilder. */
+
+public class Example {
+  public static int Count = 1000000;
+  public static int Main(String[] args) {
+    String name = "worker";
+    long total = 0;
+
+    long start = DateTime.CurrentTimeEpoch();
+    long bytes = GC.GetAllocatedBytesForCurrentThread();
+    for(int x=0;x<Count;x++) {
+      String msg = "[" + name + "] item=" + x + " of " + Count + " done=" + (x % 2 == 0) + " tag=" + 'z';
+      total += msg.Length;
+    }
+    long stop = DateTime.CurrentTimeEpoch();
+    Console.Out.WriteLine("concat=" + (stop - start) + "ms bytes/message=" + (GC.GetAllocatedBytesForCurrentThread() - bytes) / Count);
+
+    start = DateTime.CurrentTimeEpoch();
+    bytes = GC.GetAllocatedBytesForCurrentThread();
+    StringBuilder sb = new StringBuilder(64);
+    for(int x=0;x<Count;x++) {
+      sb.Clear();
+      sb.Append('[').Append(name).Append("] item=").Append(x).Append(" of ").Append(Count);
+      total += sb.Length;
+    }
+    stop = DateTime.CurrentTimeEpoch();
+    Console.Out.WriteLine("builder=" + (stop - start) + "ms bytes/message=" + (GC.GetAllocatedBytesForCurrentThread() - bytes) / Count);
+
+    start = DateTime.CurrentTimeEpoch();
+    sb.Clear();
+    for(int x=0;x<Count;x++) {
+      sb.Append(x).Append(',');
+    }
+    String all = sb.ToString();
+    stop = DateTime.CurrentTimeEpoch();
+    Console.Out.WriteLine("append=" + (stop - start) + "ms length=" + all.Length + " total=" + total);
+    return 0;
+  }
+}
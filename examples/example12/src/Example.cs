@@ -0,0 +1,128 @@
+using System;
+using System.Text;
+
+/** String kernel benchmark : the previous scalar C# loops (Scalar class) against the SSE2 / AVX2 String methods. */
+
+public class Scalar {
+  public static int IndexOf(char[] value, char[] cmp) {
+    int strLength = cmp.Length;
+    int end = value.Length - strLength;
+    for(int i=0;i<=end;i++) {
+      bool match = true;
+      for(int len=0;len<strLength;len++) {
+        if (value[i+len] != cmp[len]) {
+          match = false;
+          break;
+        }
+      }
+      if (match) return i;
+    }
+    return -1;
+  }
+  public static int IndexOf(char[] value, char ch) {
+    for(int i=0;i<value.Length;i++) {
+      if (value[i] == ch) return i;
+    }
+    return -1;
+  }
+  public static bool Equals(char[] s1, char[] s2) {
+    if (s1.Length != s2.Length) return false;
+    for(int i=0;i<s1.Length;i++) {
+      if (s1[i] != s2[i]) return false;
+    }
+    return true;
+  }
+  public static byte[] Encode(char[] value) {
+    int bytes = 0;
+    for(int a=0;a<value.Length;a++) {
+      bytes += value[a] > 127 ? 3 : 1;
+    }
+    byte[] copy = new byte[bytes];
+    int pos = 0;
+    for(int a=0;a<value.Length;a++) {
+      char ch = value[a];
+      if (ch > 127) {
+        copy[pos++] = (byte)(0xe0 + (ch >> 12));
+        copy[pos++] = (byte)(0x80 + ((ch >> 6) & 0x3f));
+        copy[pos++] = (byte)(0x80 + (ch & 0x3f));
+      } else {
+        copy[pos++] = (byte)ch;
+      }
+    }
+    return copy;
+  }
+  public static char[] Decode(byte[] utf8) {
+    int length = 0;
+    for(int a=0;a<utf8.Length;a++) {
+      int ch = utf8[a];
+      if (ch >= 0xf0) a += 3; else if (ch >= 0xe0) a += 2; else if (ch >= 0xc0) a++;
+      length++;
+    }
+    char[] value = new char[length];
+    int pos = 0;
+    for(int a=0;a<length;a++) {
+      int ch = utf8[pos++];
+      if (ch >= 0xe0) {
+        ch = ((ch & 0x0f) << 12) | ((utf8[pos] & 0x3f) << 6) | (utf8[pos+1] & 0x3f);
+        pos += 2;
+      } else if (ch >= 0xc0) {
+        ch = ((ch & 0x1f) << 6) | (utf8[pos] & 0x3f);
+        pos++;
+      }
+      value[a] = (char)ch;
+    }
+    return value;
+  }
+}
+
+public class Example {
+  public static int Loops = 2000;
+  public static void Report(String name, long scalar, long simd) {
+    Console.Out.WriteLine(name + " scalar=" + scalar + "ms simd=" + simd + "ms");
+  }
+  public static int Main(String[] args) {
+    StringBuilder sb = new StringBuilder();
+    for(int a=0;a<4096;a++) {
+      sb.Append("lorem ipsum dolor sit amet ");
+    }
+    sb.Append("needle");
+    String text = sb.ToString();
+    String copy = new String(text);
+    String needle = "needle";
+    char[] textChars = text.ToCharArray();
+    char[] copyChars = copy.ToCharArray();
+    char[] needleChars = needle.ToCharArray();
+    long found = 0;
+
+    long start = DateTime.CurrentTimeEpoch();
+    for(int a=0;a<Loops;a++) found += Scalar.IndexOf(textChars, needleChars);
+    long mid = DateTime.CurrentTimeEpoch();
+    for(int a=0;a<Loops;a++) found += text.IndexOf(needle);
+    Report("IndexOf(String)", mid - start, DateTime.CurrentTimeEpoch() - mid);
+
+    start = DateTime.CurrentTimeEpoch();
+    for(int a=0;a<Loops;a++) found += Scalar.IndexOf(textChars, 'z');
+    mid = DateTime.CurrentTimeEpoch();
+    for(int a=0;a<Loops;a++) found += text.IndexOf('z');
+    Report("IndexOf(char)", mid - start, DateTime.CurrentTimeEpoch() - mid);
+
+    start = DateTime.CurrentTimeEpoch();
+    for(int a=0;a<Loops;a++) if (Scalar.Equals(textChars, copyChars)) found++;
+    mid = DateTime.CurrentTimeEpoch();
+    for(int a=0;a<Loops;a++) if (text.Equals(copy)) found++;
+    Report("Equals", mid - start, DateTime.CurrentTimeEpoch() - mid);
+
+    start = DateTime.CurrentTimeEpoch();
+    for(int a=0;a<Loops/10;a++) found += Scalar.Decode(Scalar.Encode(textChars)).Length;
+    mid = DateTime.CurrentTimeEpoch();
+    for(int a=0;a<Loops/10;a++) found += new String(text.ToByteArray()).Length;
+    Report("UTF-8 round trip", mid - start, DateTime.CurrentTimeEpoch() - mid);
+
+    start = DateTime.CurrentTimeEpoch();
+    for(int a=0;a<Loops/10;a++) found += text.Split(" ").Length;
+    Report("Split", 0, DateTime.CurrentTimeEpoch() - start);
+
+    Console.Out.WriteLine("found=" + found);
+    return 0;
+  }
+}
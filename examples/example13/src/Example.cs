@@ -0,0 +1,118 @@
+using System;
+
+/** Devirtualization benchmark : the same work through classes that have subclasses (virtual calls, IsDerivedFrom + dynamic_cast)
+ * and through leaf classes (C++ final : direct calls, one Type compare for is / as).
+ */
+
+public abstract class Shape {
+  public int Size;
+  public abstract int Area();
+  public virtual int Scale(int factor) {return Size * factor;}
+}
+
+//OpenSquare has a subclass : calls stay virtual
+public class OpenSquare : Shape {
+  public OpenSquare(int size) {Size = size;}
+  public override int Area() {return Size * Size;}
+  public override int Scale(int factor) {return Size * factor + 1;}
+}
+public class OpenSquareEx : OpenSquare {
+  public OpenSquareEx(int size) : base(size) {}
+  public override int Area() {return Size * Size + 1;}
+  public override int Scale(int factor) {return Size * factor + 2;}
+}
+
+//Square is a leaf of the program (final), Circle is sealed
+public class Square : Shape {
+  public Square(int size) {Size = size;}
+  public override int Area() {return Size * Size;}
+  public override int Scale(int factor) {return Size * factor + 1;}
+}
+public sealed class Circle : Shape {
+  public Circle(int size) {Size = size;}
+  public override int Area() {return 3 * Size * Size;}
+}
+
+public class Example {
+  public static int Loops = 2000;
+  public static int Count = 10000;
+  public static void Report(String name, long open, long leaf) {
+    Console.Out.WriteLine(name + " virtual=" + open + "ms direct=" + leaf + "ms");
+  }
+  public static long SumOpen(OpenSquare[] items) {
+    long sum = 0;
+    for(int i=0;i<items.Length;i++) sum += items[i].Area() + items[i].Scale(3);
+    return sum;
+  }
+  public static long SumLeaf(Square[] items) {
+    long sum = 0;
+    for(int i=0;i<items.Length;i++) sum += items[i].Area() + items[i].Scale(3);
+    return sum;
+  }
+  public static long CountOpen(Object[] items) {
+    long count = 0;
+    for(int i=0;i<items.Length;i++) {
+      if (items[i] is OpenSquare) count++;
+      OpenSquare square = items[i] as OpenSquare;
+      if (square != null) count += square.Size;
+    }
+    return count;
+  }
+  public static long CountLeaf(Object[] items) {
+    long count = 0;
+    for(int i=0;i<items.Length;i++) {
+      if (items[i] is Circle) count++;
+      Circle circle = items[i] as Circle;
+      if (circle != null) count += circle.Size;
+    }
+    return count;
+  }
+  public static long LocalOpen(Shape shape) {
+    long sum = 0;
+    for(int i=0;i<Count;i++) sum += shape.Scale(i);
+    return sum;
+  }
+  public static long LocalExact() {
+    OpenSquare shape = new OpenSquare(7);  //only ever holds an OpenSquare : bound to OpenSquare::Scale()
+    long sum = 0;
+    for(int i=0;i<Count;i++) sum += shape.Scale(i);
+    return sum;
+  }
+  public static int Main(String[] args) {
+    OpenSquare[] open = new OpenSquare[Count];
+    Square[] leaf = new Square[Count];
+    Object[] mixed = new Object[Count];
+    for(int a=0;a<Count;a++) {
+      open[a] = new OpenSquare(a & 15);
+      leaf[a] = new Square(a & 15);
+      switch (a % 3) {
+        case 0: mixed[a] = new OpenSquare(a & 15); break;
+        case 1: mixed[a] = new Circle(a & 15); break;
+        default: mixed[a] = new OpenSquareEx(a & 15); break;
+      }
+    }
+    long total = 0;
+
+    long start = DateTime.CurrentTimeEpoch();
+    for(int a=0;a<Loops;a++) total += SumOpen(open);
+    long mid = DateTime.CurrentTimeEpoch();
+    for(int a=0;a<Loops;a++) total += SumLeaf(leaf);
+    Report("calls", mid - start, DateTime.CurrentTimeEpoch() - mid);
+
+    start = DateTime.CurrentTimeEpoch();
+    for(int a=0;a<Loops;a++) total += CountOpen(mixed);
+    mid = DateTime.CurrentTimeEpoch();
+    for(int a=0;a<Loops;a++) total += CountLeaf(mixed);
+    Report("is/as", mid - start, DateTime.CurrentTimeEpoch() - mid);
+
+    Shape shape = new OpenSquare(7);
+    start = DateTime.CurrentTimeEpoch();
+    for(int a=0;a<Loops;a++) total += LocalOpen(shape);
+    mid = DateTime.CurrentTimeEpoch();
+    for(int a=0;a<Loops;a++) total += LocalExact();
+    Report("exact local", mid - start, DateTime.CurrentTimeEpoch() - mid);
+
+    Console.Out.WriteLine("total=" + total);
+    return 0;
+  }
+}
@@ -0,0 +1,107 @@
+using System;
+using System.Collections;
+using System.Text;
+
+/** foreach benchmark : an IEnumerator<T> loop (what foreach compiled to before : one allocation per loop and
+ * two virtual calls per element) against foreach over T[], Array<T>, List<T>, String and a struct enumerator.
+ * Prints time and objects allocated by each pass.
+ */
+
+public class Item {
+  public int Value;
+  public Item(int value) {Value = value;}
+}
+
+//duck-typed enumerable : GetEnumerator() returns a struct, no interface
+public class Range {
+  public int Start;
+  public int End;
+  public Range(int start, int end) {Start = start; End = end;}
+  public RangeEnumerator GetEnumerator() {
+    return new RangeEnumerator(Start, End);
+  }
+}
+public struct RangeEnumerator {
+  private int current;
+  private int end;
+  public RangeEnumerator(int start, int end) {current = start - 1; this.end = end;}
+  public bool MoveNext() {
+    current++;
+    return current < end;
+  }
+  public int Current {
+    get {return current;}
+  }
+}
+
+public class Example {
+  public static int Loops = 2000;
+  public static int Count = 10000;
+  public static long start;
+  public static long allocs;
+  public static void Start() {
+    start = DateTime.CurrentTimeEpoch();
+    allocs = GC.GetAllocationCountForCurrentThread();
+  }
+  public static void Report(String name) {
+    long time = DateTime.CurrentTimeEpoch() - start;
+    long count = GC.GetAllocationCountForCurrentThread() - allocs;
+    Console.Out.WriteLine(name + " " + time + "ms allocations=" + count);
+  }
+  public static int Main(String[] args) {
+    Item[] array = new Item[Count];
+    Array<Item> items = new Array<Item>();
+    List<Item> list = new List<Item>();
+    StringBuilder sb = new StringBuilder();
+    for(int a=0;a<Count;a++) {
+      Item item = new Item(a);
+      array[a] = item;
+      items.Add(item);
+      list.Add(item);
+      sb.Append((char)('a' + a % 26));
+    }
+    String text = sb.ToString();
+    Range range = new Range(0, Count);
+    long sum = 0;
+
+    Start();
+    for(int a=0;a<Loops;a++) {
+      IEnumerator<Item> e = list.GetEnumerator();
+      while (e.MoveNext()) sum += e.Current.Value;
+    }
+    Report("IEnumerator<T> List<T>");
+
+    Start();
+    for(int a=0;a<Loops;a++) {
+      foreach(Item item in array) sum += item.Value;
+    }
+    Report("foreach T[]");
+
+    Start();
+    for(int a=0;a<Loops;a++) {
+      foreach(Item item in items) sum += item.Value;
+    }
+    Report("foreach Array<T>");
+
+    Start();
+    for(int a=0;a<Loops;a++) {
+      foreach(Item item in list) sum += item.Value;
+    }
+    Report("foreach List<T>");
+
+    Start();
+    for(int a=0;a<Loops;a++) {
+      foreach(char ch in text) sum += ch;
+    }
+    Report("foreach String");
+
+    Start();
+    for(int a=0;a<Loops;a++) {
+      foreach(int i in range) sum += i;
+    }
+    Report("foreach struct enumerator");
+
+    Console.Out.WriteLine("sum=" + sum);
+    return 0;
+  }
+}
@@ -0,0 +1,123 @@
+using System;
+
+/** String switch benchmark : a 40 case command dispatcher as a chain of Equals() tests (what switch compiled to before)
+ * against switch (one GetHashCode(), a switch on the hash and one Equals() against the pooled literal).
+ */
+
+public class Example {
+  public static int Loops = 20000;
+  public static String[] Words = {"open", "close", "read", "write", "seek", "tell", "flush", "sync", "stat", "chmod", "chown", "mkdir", "rmdir", "rename", "link", "unlink", "copy", "move", "list", "find", "grep", "sort", "uniq", "head", "tail", "cut", "paste", "join", "split", "merge", "push", "pop", "peek", "clear", "reset", "start", "stop", "pause", "resume", "status"};
+
+  public static int Chain(String cmd) {
+    if (cmd.Equals("open")) return 1;
+    if (cmd.Equals("close")) return 2;
+    if (cmd.Equals("read")) return 3;
+    if (cmd.Equals("write")) return 4;
+    if (cmd.Equals("seek")) return 5;
+    if (cmd.Equals("tell")) return 6;
+    if (cmd.Equals("flush")) return 7;
+    if (cmd.Equals("sync")) return 8;
+    if (cmd.Equals("stat")) return 9;
+    if (cmd.Equals("chmod")) return 10;
+    if (cmd.Equals("chown")) return 11;
+    if (cmd.Equals("mkdir")) return 12;
+    if (cmd.Equals("rmdir")) return 13;
+    if (cmd.Equals("rename")) return 14;
+    if (cmd.Equals("link")) return 15;
+    if (cmd.Equals("unlink")) return 16;
+    if (cmd.Equals("copy")) return 17;
+    if (cmd.Equals("move")) return 18;
+    if (cmd.Equals("list")) return 19;
+    if (cmd.Equals("find")) return 20;
+    if (cmd.Equals("grep")) return 21;
+    if (cmd.Equals("sort")) return 22;
+    if (cmd.Equals("uniq")) return 23;
+    if (cmd.Equals("head")) return 24;
+    if (cmd.Equals("tail")) return 25;
+    if (cmd.Equals("cut")) return 26;
+    if (cmd.Equals("paste")) return 27;
+    if (cmd.Equals("join")) return 28;
+    if (cmd.Equals("split")) return 29;
+    if (cmd.Equals("merge")) return 30;
+    if (cmd.Equals("push")) return 31;
+    if (cmd.Equals("pop")) return 32;
+    if (cmd.Equals("peek")) return 33;
+    if (cmd.Equals("clear")) return 34;
+    if (cmd.Equals("reset")) return 35;
+    if (cmd.Equals("start")) return 36;
+    if (cmd.Equals("stop")) return 37;
+    if (cmd.Equals("pause")) return 38;
+    if (cmd.Equals("resume")) return 39;
+    if (cmd.Equals("status")) return 40;
+    return 0;
+  }
+
+  public static int Switch(String cmd) {
+    switch (cmd) {
+      case "open": return 1;
+      case "close": return 2;
+      case "read": return 3;
+      case "write": return 4;
+      case "seek": return 5;
+      case "tell": return 6;
+      case "flush": return 7;
+      case "sync": return 8;
+      case "stat": return 9;
+      case "chmod": return 10;
+      case "chown": return 11;
+      case "mkdir": return 12;
+      case "rmdir": return 13;
+      case "rename": return 14;
+      case "link": return 15;
+      case "unlink": return 16;
+      case "copy": return 17;
+      case "move": return 18;
+      case "list": return 19;
+      case "find": return 20;
+      case "grep": return 21;
+      case "sort": return 22;
+      case "uniq": return 23;
+      case "head": return 24;
+      case "tail": return 25;
+      case "cut": return 26;
+      case "paste": return 27;
+      case "join": return 28;
+      case "split": return 29;
+      case "merge": return 30;
+      case "push": return 31;
+      case "pop": return 32;
+      case "peek": return 33;
+      case "clear": return 34;
+      case "reset": return 35;
+      case "start": return 36;
+      case "stop": return 37;
+      case "pause": return 38;
+      case "resume": return 39;
+      case "status": return 40;
+      default: return 0;
+    }
+  }
+
+  public static int Main(String[] args) {
+    //commands as they come from input : new Strings (not the interned literals)
+    String[] commands = new String[Words.Length + 1];
+    for(int a=0;a<Words.Length;a++) {
+      commands[a] = new String(Words[a].ToCharArray());
+    }
+    commands[Words.Length] = new String("unknown");
+    long total = 0;
+
+    long start = DateTime.CurrentTimeEpoch();
+    for(int a=0;a<Loops;a++) {
+      for(int c=0;c<commands.Length;c++) total += Chain(commands[c]);
+    }
+    long mid = DateTime.CurrentTimeEpoch();
+    for(int a=0;a<Loops;a++) {
+      for(int c=0;c<commands.Length;c++) total += Switch(commands[c]);
+    }
+    long end = DateTime.CurrentTimeEpoch();
+    Console.Out.WriteLine("dispatch chain=" + (mid - start) + "ms switch=" + (end - mid) + "ms");
+    Console.Out.WriteLine("total=" + total);
+    return 0;
+  }
+}
@@ -0,0 +1,151 @@
+using System;
+
+/** Value type benchmark : a small N-body simulation with vectors as classes (every operation allocates, bodies are
+ * an array of pointers to objects holding pointers to vectors) against vectors as structs (locals on the stack,
+ * bodies stored inline in one array, accumulators passed by ref).
+ * corelib has no floating point types : values are fixed point longs (Scale = 1.0).
+ * The force is softened and has no square root, it only has to be the same for both (long arithmetic wraps the same way).
+ */
+
+public class VectorC {
+  public long X, Y, Z;
+  public VectorC(long x, long y, long z) {X = x; Y = y; Z = z;}
+  public VectorC Add(VectorC o) {return new VectorC(X + o.X, Y + o.Y, Z + o.Z);}
+  public VectorC Sub(VectorC o) {return new VectorC(X - o.X, Y - o.Y, Z - o.Z);}
+  public VectorC Scale(long s) {return new VectorC(X * s / Example.Scale, Y * s / Example.Scale, Z * s / Example.Scale);}
+  public long Dot(VectorC o) {return (X * o.X + Y * o.Y + Z * o.Z) / Example.Scale;}
+}
+
+public class BodyC {
+  public VectorC Position;
+  public VectorC Velocity;
+  public long Mass;
+}
+
+public struct Vector3 {
+  public long X, Y, Z;
+  public Vector3(long x, long y, long z) {X = x; Y = y; Z = z;}
+  public Vector3 Add(Vector3 o) {return new Vector3(X + o.X, Y + o.Y, Z + o.Z);}
+  public Vector3 Sub(Vector3 o) {return new Vector3(X - o.X, Y - o.Y, Z - o.Z);}
+  public Vector3 Scale(long s) {return new Vector3(X * s / Example.Scale, Y * s / Example.Scale, Z * s / Example.Scale);}
+  public long Dot(in Vector3 o) {return (X * o.X + Y * o.Y + Z * o.Z) / Example.Scale;}
+}
+
+public struct Body {
+  public Vector3 Position;
+  public Vector3 Velocity;
+  public long Mass;
+}
+
+public class Example {
+  public static long Scale = 1000;
+  public static int Count = 500;
+  public static int Steps = 100;
+  public static long Dt = 10;  //0.01
+  public static long Soft = 1000;  //1.0
+
+  public static long Start(int a, int axis) {
+    return ((a * 7919 + axis * 104729) % 1000) * 10;
+  }
+
+  //mass / r2^2 in fixed point
+  public static long Force(long mass, long r2) {
+    return mass * Scale / r2 * Scale / r2;
+  }
+
+  public static BodyC[] CreateC() {
+    BodyC[] bodies = new BodyC[Count];
+    for(int a=0;a<Count;a++) {
+      BodyC body = new BodyC();
+      body.Position = new VectorC(Start(a, 0), Start(a, 1), Start(a, 2));
+      body.Velocity = new VectorC(0, 0, 0);
+      body.Mass = Scale + (a % 10) * Scale / 10;
+      bodies[a] = body;
+    }
+    return bodies;
+  }
+
+  public static Body[] Create() {
+    Body[] bodies = new Body[Count];
+    for(int a=0;a<Count;a++) {
+      bodies[a].Position = new Vector3(Start(a, 0), Start(a, 1), Start(a, 2));
+      bodies[a].Mass = Scale + (a % 10) * Scale / 10;
+    }
+    return bodies;
+  }
+
+  public static void StepC(BodyC[] bodies) {
+    for(int i=0;i<bodies.Length;i++) {
+      BodyC bi = bodies[i];
+      VectorC acc = new VectorC(0, 0, 0);
+      for(int j=0;j<bodies.Length;j++) {
+        if (i == j) continue;
+        VectorC d = bodies[j].Position.Sub(bi.Position);
+        long r2 = d.Dot(d) + Soft;
+        acc = acc.Add(d.Scale(Force(bodies[j].Mass, r2)));
+      }
+      bi.Velocity = bi.Velocity.Add(acc.Scale(Dt));
+    }
+    for(int i=0;i<bodies.Length;i++) {
+      BodyC bi = bodies[i];
+      bi.Position = bi.Position.Add(bi.Velocity.Scale(Dt));
+    }
+  }
+
+  //acc += d * s without a temporary
+  public static void AddScaled(ref Vector3 acc, in Vector3 d, long s) {
+    acc.X += d.X * s / Scale;
+    acc.Y += d.Y * s / Scale;
+    acc.Z += d.Z * s / Scale;
+  }
+
+  public static void Step(Body[] bodies) {
+    for(int i=0;i<bodies.Length;i++) {
+      Vector3 pos = bodies[i].Position;
+      Vector3 acc = new Vector3(0, 0, 0);
+      for(int j=0;j<bodies.Length;j++) {
+        if (i == j) continue;
+        Vector3 d = bodies[j].Position.Sub(pos);
+        long r2 = d.Dot(d) + Soft;
+        AddScaled(ref acc, d, Force(bodies[j].Mass, r2));
+      }
+      AddScaled(ref bodies[i].Velocity, acc, Dt);
+    }
+    for(int i=0;i<bodies.Length;i++) {
+      AddScaled(ref bodies[i].Position, bodies[i].Velocity, Dt);
+    }
+  }
+
+  public static long CheckSumC(BodyC[] bodies) {
+    long sum = 0;
+    for(int a=0;a<bodies.Length;a++) {
+      sum += bodies[a].Position.X + bodies[a].Position.Y + bodies[a].Position.Z;
+    }
+    return sum;
+  }
+
+  public static long CheckSum(Body[] bodies) {
+    long sum = 0;
+    for(int a=0;a<bodies.Length;a++) {
+      sum += bodies[a].Position.X + bodies[a].Position.Y + bodies[a].Position.Z;
+    }
+    return sum;
+  }
+
+  public static int Main(String[] args) {
+    BodyC[] classBodies = CreateC();
+    long allocs = GC.GetAllocationCountForCurrentThread();
+    long start = DateTime.CurrentTimeEpoch();
+    for(int s=0;s<Steps;s++) StepC(classBodies);
+    long end = DateTime.CurrentTimeEpoch();
+    Console.Out.WriteLine("class vectors " + (end - start) + "ms allocations=" + (GC.GetAllocationCountForCurrentThread() - allocs) + " checksum=" + CheckSumC(classBodies));
+
+    Body[] bodies = Create();
+    allocs = GC.GetAllocationCountForCurrentThread();
+    start = DateTime.CurrentTimeEpoch();
+    for(int s=0;s<Steps;s++) Step(bodies);
+    end = DateTime.CurrentTimeEpoch();
+    Console.Out.WriteLine("struct vectors " + (end - start) + "ms allocations=" + (GC.GetAllocationCountForCurrentThread() - allocs) + " checksum=" + CheckSum(bodies));
+    return 0;
+  }
+}
@@ -0,0 +1,34 @@
+using System;
+
+/** Allocation benchmark : each thread allocates small objects as fast as possible. */
+
+public class Worker : Thread {
+  public int count;
+  public Object last;
+  public override void Run() {
+    for(int a=0;a<count;a++) {
+      last = new Object();
+    }
+  }
+}
+
+public class Example {
+  public static int Main(String[] args) {
+    int total = 4000000;
+    for(int threads=1;threads<=8;threads*=2) {
+      Worker[] workers = new Worker[threads];
+      long start = DateTime.CurrentTimeEpoch();
+      for(int a=0;a<threads;a++) {
+        workers[a] = new Worker();
+        workers[a].count = total / threads;
+        workers[a].Start();
+      }
+      for(int a=0;a<threads;a++) {
+        workers[a].Join();
+      }
+      long end = DateTime.CurrentTimeEpoch();
+      Console.WriteLine("threads=" + threads + " objects=" + total + " ms=" + (end - start));
+    }
+    return 0;
+  }
+}
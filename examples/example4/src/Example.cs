@@ -0,0 +1,43 @@
+using System;
+
+/** GC pause benchmark : keeps a large live heap while allocating garbage.
+ * Run with CCSHARP_GC_CONCURRENT=1 to compare concurrent marking pauses
+ * or CCSHARP_GC_GENERATIONAL=1 to compare minor collections. */
+
+public class Node {
+  public Node left;
+  public Node right;
+  public long value;
+}
+
+public class Example {
+  public static Node Build(int depth) {
+    Node node = new Node();
+    if (depth > 0) {
+      node.left = Build(depth - 1);
+      node.right = Build(depth - 1);
+    }
+    return node;
+  }
+  public static int Main(String[] args) {
+    Node live = Build(20);  //2M live objects
+    GC.ResetPauses();
+    long start = DateTime.CurrentTimeEpoch();
+    for(int a=0;a<200;a++) {
+      Build(14);  //garbage
+      live.left.value = a;
+    }
+    long end = DateTime.CurrentTimeEpoch();
+    long count = GC.GetPauseCount();
+    Console.WriteLine("concurrent=" + GC.IsConcurrent() + " ms=" + (end - start) + " collections=" + GC.CollectionCount());
+    if (count > 0) {
+      Console.WriteLine("pauses=" + count + " max(us)=" + GC.GetMaxPause() + " avg(us)=" + (GC.GetTotalPause() / count));
+      for(int b=0;b<GC.GetPauseBucketCount();b++) {
+        long hits = GC.GetPauseHistogram(b);
+        if (hits > 0) Console.WriteLine("  < " + (1L << b) + "us : " + hits);
+      }
+    }
+    Console.WriteLine("live=" + GC.GetLiveBytes() + " allocated=" + GC.GetAllocatedBytesForCurrentThread());
+    return 0;
+  }
+}
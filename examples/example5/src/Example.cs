@@ -0,0 +1,23 @@
+using System;
+
+/** Fragmentation benchmark : allocates objects of many sizes (small and large) and reports heap usage. */
+
+public class Example {
+  public static int Main(String[] args) {
+    Object[] live = new Object[10000];
+    long start = DateTime.CurrentTimeEpoch();
+    int size = 1;
+    for(int a=0;a<1000000;a++) {
+      size = (size * 7 + 13) % 3000;
+      if (a % 1000 == 0) {
+        live[a % live.Length] = new byte[100000 + size * 100];  //large object
+      } else {
+        live[a % live.Length] = new byte[size];
+      }
+    }
+    long end = DateTime.CurrentTimeEpoch();
+    Console.WriteLine("ms=" + (end - start) + " collections=" + GC.CollectionCount());
+    Console.WriteLine("heap=" + GC.GetHeapSize() + " used=" + GC.GetHeapUsed() + " fragmentation=" + GC.GetFragmentation() + "/1000");
+    return 0;
+  }
+}
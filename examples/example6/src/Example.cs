@@ -0,0 +1,89 @@
+using System;
+using System.Threading;
+
+/** Fork-join benchmark : sums a binary tree of small work items, forking at every level.
+ * Compares one Thread per fork with Tasks on the work stealing ThreadPool. */
+
+public class Work {
+  public static long Leaf(int seed) {
+    long sum = seed;
+    for(int a=0;a<2000;a++) {
+      sum = sum * 31 + a;
+    }
+    return sum & 0xffff;
+  }
+}
+
+public class SumThread : Thread {
+  private int depth;
+  private int seed;
+  public long result;
+  public SumThread(int depth, int seed) {
+    this.depth = depth;
+    this.seed = seed;
+  }
+  public override void Run() {
+    if (depth == 0) {
+      result = Work.Leaf(seed);
+      return;
+    }
+    SumThread left = new SumThread(depth - 1, seed * 2);
+    SumThread right = new SumThread(depth - 1, seed * 2 + 1);
+    left.Start();
+    right.Run();
+    left.Join();
+    result = left.result + right.result;
+  }
+}
+
+public class SumTask : Task {
+  private int depth;
+  private int seed;
+  public long result;
+  public SumTask(int depth, int seed) {
+    this.depth = depth;
+    this.seed = seed;
+  }
+  public override void Run() {
+    if (depth == 0) {
+      result = Work.Leaf(seed);
+      return;
+    }
+    SumTask left = new SumTask(depth - 1, seed * 2);
+    SumTask right = new SumTask(depth - 1, seed * 2 + 1);
+    left.Start();
+    right.Run();
+    left.Wait();
+    result = left.result + right.result;
+  }
+}
+
+public class Example {
+  public static int Main(String[] args) {
+    int depth = 12;  //4095 forks per round
+    int rounds = 5;
+    Console.WriteLine("workers=" + ThreadPool.GetDefault().GetThreadCount() + " forks/round=" + ((1 << depth) - 1));
+
+    long start = DateTime.CurrentTimeEpoch();
+    long sum1 = 0;
+    for(int r=0;r<rounds;r++) {
+      SumThread thread = new SumThread(depth, 1);
+      thread.Run();
+      sum1 += thread.result;
+    }
+    long end = DateTime.CurrentTimeEpoch();
+    Console.WriteLine("thread per task : ms=" + (end - start) + " sum=" + sum1);
+
+    start = DateTime.CurrentTimeEpoch();
+    long sum2 = 0;
+    for(int r=0;r<rounds;r++) {
+      SumTask task = new SumTask(depth, 1);
+      task.Start();
+      task.Wait();
+      sum2 += task.result;
+    }
+    end = DateTime.CurrentTimeEpoch();
+    Console.WriteLine("thread pool : ms=" + (end - start) + " sum=" + sum2);
+    return 0;
+  }
+}
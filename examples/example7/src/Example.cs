@@ -0,0 +1,53 @@
+using System;
+
+/** Lock benchmark : uncontended Lock() / Unlock() then several threads incrementing a shared counter.
+ * Prints the contention counters of the shared Mutex. */
+
+public class Counter {
+  public Mutex mutex = new Mutex();
+  public long value;
+}
+
+public class Worker : Thread {
+  private Counter counter;
+  private int count;
+  public Worker(Counter counter, int count) {
+    this.counter = counter;
+    this.count = count;
+  }
+  public override void Run() {
+    for(int a=0;a<count;a++) {
+      counter.mutex.Lock();
+      counter.value++;
+      counter.mutex.Unlock();
+    }
+  }
+}
+
+public class Example {
+  public static int Main(String[] args) {
+    int count = 1000000;
+    Counter single = new Counter();
+    long start = DateTime.CurrentTimeEpoch();
+    new Worker(single, count * 10).Run();
+    long end = DateTime.CurrentTimeEpoch();
+    Console.WriteLine("uncontended : ms=" + (end - start) + " locks=" + single.value);
+
+    for(int threads=2;threads<=8;threads*=2) {
+      Counter shared = new Counter();
+      Worker[] workers = new Worker[threads];
+      start = DateTime.CurrentTimeEpoch();
+      for(int a=0;a<threads;a++) {
+        workers[a] = new Worker(shared, count);
+        workers[a].Start();
+      }
+      for(int a=0;a<threads;a++) {
+        workers[a].Join();
+      }
+      end = DateTime.CurrentTimeEpoch();
+      Console.WriteLine("threads=" + threads + " : ms=" + (end - start) + " locks=" + shared.value
+        + " contended=" + shared.mutex.GetContentionCount() + " slept=" + shared.mutex.GetSleepCount());
+    }
+    return 0;
+  }
+}
@@ -0,0 +1,86 @@
+using System;
+using System.Collections;
+
+/** Concurrent collections throughput with 1 to 32 threads.
+ * Each thread enqueues then dequeues items (queues) or adds then looks up keys (map).
+ * The locked List is the baseline. */
+
+public class Item {
+  public int value;
+  public Item(int value) {
+    this.value = value;
+  }
+}
+
+public class Shared {
+  public int mode;
+  public List<Item> list = new List<Item>();
+  public Mutex listLock = new Mutex();
+  public ConcurrentQueue<Item> queue = new ConcurrentQueue<Item>();
+  public BoundedQueue<Item> ring = new BoundedQueue<Item>(65536);
+  public ConcurrentDictionary<String, Item> map = new ConcurrentDictionary<String, Item>();
+}
+
+public class Worker : Thread {
+  public static int Count = 100000;
+  private Shared shared;
+  private int id;
+  public Worker(Shared shared, int id) {
+    this.shared = shared;
+    this.id = id;
+  }
+  public override void Run() {
+    Item item = new Item(id);
+    for(int a=0;a<Count;a++) {
+      switch (shared.mode) {
+        case 0:
+          shared.listLock.Lock();
+          shared.list.Add(item);
+          shared.listLock.Unlock();
+          shared.listLock.Lock();
+          shared.list.Remove(shared.list.Get(0));
+          shared.listLock.Unlock();
+          break;
+        case 1:
+          shared.queue.Enqueue(item);
+          while (shared.queue.TryDequeue() == null) {}
+          break;
+        case 2:
+          while (!shared.ring.TryEnqueue(item)) {}
+          while (shared.ring.TryDequeue() == null) {}
+          break;
+        case 3:
+          String key = "k" + ((id * Count + a) & 0xffff);
+          shared.map.GetOrAdd(key, item);
+          shared.map.Get(key);
+          break;
+      }
+    }
+  }
+}
+
+public class Example {
+  public static int Main(String[] args) {
+    String[] names = {"locked List", "ConcurrentQueue", "BoundedQueue", "ConcurrentDictionary"};
+    for(int mode=0;mode<4;mode++) {
+      for(int threads=1;threads<=32;threads*=2) {
+        Shared shared = new Shared();
+        shared.mode = mode;
+        Worker[] workers = new Worker[threads];
+        long start = DateTime.CurrentTimeEpoch();
+        for(int a=0;a<threads;a++) {
+          workers[a] = new Worker(shared, a);
+          workers[a].Start();
+        }
+        for(int a=0;a<threads;a++) {
+          workers[a].Join();
+        }
+        long ms = DateTime.CurrentTimeEpoch() - start;
+        if (ms == 0) ms = 1;
+        long ops = (long)threads * Worker.Count * 2;
+        Console.WriteLine(names[mode] + " threads=" + threads + " ms=" + ms + " ops/ms=" + (ops / ms));
+      }
+    }
+    return 0;
+  }
+}
@@ -0,0 +1,57 @@
+using System;
+
+/** Lookup benchmark : Array<T>.IndexOf (linear scan) against Dictionary and HashSet. */
+
+public class Value {
+  public int id;
+  public Value(int id) {
+    this.id = id;
+  }
+}
+
+public class Example {
+  public static int Main(String[] args) {
+    for(int size=16;size<=16384;size*=4) {
+      String[] keys = new String[size];
+      Array<String> array = new Array<String>();
+      Dictionary<String, Value> map = new Dictionary<String, Value>();
+      HashSet<String> set = new HashSet<String>();
+      for(int a=0;a<size;a++) {
+        keys[a] = "key" + a;
+        array.Add(keys[a]);
+        map.Set(keys[a], new Value(a));
+        set.Add(keys[a]);
+      }
+      int lookups = 1000000;
+      if (size > 1024) lookups = 100000;  //linear scan gets slow
+
+      long start = DateTime.CurrentTimeEpoch();
+      long found = 0;
+      for(int a=0;a<lookups;a++) {
+        if (array.IndexOf(keys[(a * 7) % size]) != -1) found++;
+      }
+      long arrayMs = DateTime.CurrentTimeEpoch() - start;
+
+      start = DateTime.CurrentTimeEpoch();
+      for(int a=0;a<lookups;a++) {
+        if (map.Get(keys[(a * 7) % size]) != null) found++;
+      }
+      long mapMs = DateTime.CurrentTimeEpoch() - start;
+
+      start = DateTime.CurrentTimeEpoch();
+      for(int a=0;a<lookups;a++) {
+        if (set.Contains(keys[(a * 7) % size])) found++;
+      }
+      long setMs = DateTime.CurrentTimeEpoch() - start;
+
+      //allocation free enumeration
+      long sum = 0;
+      for(int i=map.Next(-1);i!=-1;i=map.Next(i)) {
+        sum += map.ValueAt(i).id;
+      }
+      Console.WriteLine("size=" + size + " lookups=" + lookups + " IndexOf ms=" + arrayMs + " Dictionary ms=" + mapMs
+        + " HashSet ms=" + setMs + " found=" + found + " sum=" + sum);
+    }
+    return 0;
+  }
+}